@@ -0,0 +1,299 @@
+#include <math.h>
+#include <time.h>
+#include "Simulator.h"
+
+/*
+ * Host-side throughput of the simulator: how many accesses per second the
+ * model built by this directory runs, not how many cycles it simulates.
+ * Every pattern is generated up front and replayed runs times on a fresh
+ * cache, once through read()/write() and once through accessBatch().
+ */
+#ifndef BENCH_MODEL
+#define BENCH_MODEL "unknown"
+#endif
+
+#define DEFAULT_ACCESSES (1u << 20)
+#define DEFAULT_RUNS 11
+#define STRIDE_BLOCKS 17         // strided pattern jumps 17 blocks
+#define ZIPF_EXPONENT 0.99
+#define WRITE_PERCENT 30         // random and Zipfian patterns
+#define MATRIX_SIZE 64           // 3 matrices of 64x64 words fit in DRAM
+#define TILE_SIZE 16
+
+typedef struct Pattern {
+  const char *name;
+  uint64_t *addresses;
+  uint8_t *modes;
+  uint32_t count;
+  int chase;               // addresses[0] starts a chain stored in memory
+} Pattern;
+
+static uint64_t randomState = 0x9E3779B97F4A7C15ull;
+
+static uint64_t nextRandom(void) {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 7;
+  randomState ^= randomState << 17;
+  return randomState;
+}
+
+static double nowNs(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**************** Patterns ***************/
+static void sequential(Pattern *pattern, const CacheConfig *config) {
+  for (uint32_t i = 0; i < pattern->count; i++) {
+    pattern->addresses[i] = (uint64_t)i * WORD_SIZE % config->dramSize;
+    pattern->modes[i] = MODE_READ;
+  }
+}
+
+static void strided(Pattern *pattern, const CacheConfig *config) {
+  uint64_t stride = (uint64_t)STRIDE_BLOCKS * config->blockSize;
+
+  // Shift by one word on every wrap so the pattern visits every word
+  for (uint32_t i = 0; i < pattern->count; i++) {
+    uint64_t position = (uint64_t)i * stride;
+    uint64_t wraps = position / config->dramSize;
+    pattern->addresses[i] = (position + wraps * WORD_SIZE) % config->dramSize;
+    pattern->modes[i] = MODE_READ;
+  }
+}
+
+static void uniform(Pattern *pattern, const CacheConfig *config) {
+  uint32_t words = config->dramSize / WORD_SIZE;
+
+  for (uint32_t i = 0; i < pattern->count; i++) {
+    pattern->addresses[i] = nextRandom() % words * WORD_SIZE;
+    pattern->modes[i] = nextRandom() % 100 < WRITE_PERCENT ? MODE_WRITE : MODE_READ;
+  }
+}
+
+/**
+ * Function used to draw blocks with Zipf probabilities: the block of rank r
+ * is picked with probability proportional to 1 / r^ZIPF_EXPONENT. Ranks are
+ * scattered over DRAM so the popular blocks don't share sets.
+ */
+static void zipfian(Pattern *pattern, const CacheConfig *config) {
+  uint32_t blocks = config->dramSize / config->blockSize;
+  double *cdf = malloc(blocks * sizeof(double));
+  double sum = 0;
+
+  for (uint32_t r = 0; r < blocks; r++) {
+    sum += 1.0 / pow(r + 1, ZIPF_EXPONENT);
+    cdf[r] = sum;
+  }
+
+  for (uint32_t i = 0; i < pattern->count; i++) {
+    double target = (double)(nextRandom() >> 11) / (1ull << 53) * sum;
+    uint32_t low = 0, high = blocks - 1;
+    while (low < high) {
+      uint32_t middle = (low + high) / 2;
+      if (cdf[middle] < target)
+        low = middle + 1;
+      else
+        high = middle;
+    }
+
+    uint32_t block = (low * 2654435761u) & (blocks - 1);
+    uint32_t word = nextRandom() % (config->blockSize / WORD_SIZE);
+    pattern->addresses[i] = (uint64_t)block * config->blockSize + word * WORD_SIZE;
+    pattern->modes[i] = nextRandom() % 100 < WRITE_PERCENT ? MODE_WRITE : MODE_READ;
+  }
+
+  free(cdf);
+}
+
+/**
+ * Function used to build a single random cycle over every block (Sattolo's
+ * algorithm). The run stores it in simulated memory and follows it with
+ * reads, each address coming out of the previous read.
+ */
+static void pointerChase(Pattern *pattern, const CacheConfig *config) {
+  uint32_t blocks = config->dramSize / config->blockSize;
+
+  for (uint32_t i = 0; i < blocks; i++)
+    pattern->addresses[i] = (uint64_t)i * config->blockSize;
+  for (uint32_t i = blocks - 1; i > 0; i--) {
+    uint32_t j = nextRandom() % i;
+    uint64_t swap = pattern->addresses[i];
+    pattern->addresses[i] = pattern->addresses[j];
+    pattern->addresses[j] = swap;
+  }
+  pattern->chase = 1;
+}
+
+/**
+ * Function used to generate C += A * B over MATRIX_SIZE square matrices of
+ * words, tiled by TILE_SIZE: two reads per multiply and a read and a write
+ * of C per tile row.
+ */
+static void tiledMatmul(Pattern *pattern, const CacheConfig *config) {
+  uint32_t matrix = MATRIX_SIZE * MATRIX_SIZE * WORD_SIZE;
+  uint32_t a = 0, b = matrix % config->dramSize, c = 2 * matrix % config->dramSize;
+  uint32_t i = 0;
+
+#define EMIT(base, row, column, mode)                                                  \
+  do {                                                                                 \
+    pattern->addresses[i] = ((base) + ((row) * MATRIX_SIZE + (column)) * WORD_SIZE) %  \
+                            config->dramSize;                                          \
+    pattern->modes[i] = (mode);                                                        \
+    if (++i == pattern->count)                                                         \
+      return;                                                                          \
+  } while (0)
+
+  for (;;) {
+    for (uint32_t ii = 0; ii < MATRIX_SIZE; ii += TILE_SIZE)
+      for (uint32_t jj = 0; jj < MATRIX_SIZE; jj += TILE_SIZE)
+        for (uint32_t kk = 0; kk < MATRIX_SIZE; kk += TILE_SIZE)
+          for (uint32_t r = ii; r < ii + TILE_SIZE; r++)
+            for (uint32_t col = jj; col < jj + TILE_SIZE; col++) {
+              EMIT(c, r, col, MODE_READ);
+              for (uint32_t k = kk; k < kk + TILE_SIZE; k++) {
+                EMIT(a, r, k, MODE_READ);
+                EMIT(b, k, col, MODE_READ);
+              }
+              EMIT(c, r, col, MODE_WRITE);
+            }
+  }
+#undef EMIT
+}
+
+/**************** Runs ***************/
+/**
+ * Function used to time one replay of a pattern on a cleared cache.
+ * Returns the host time per access, in ns.
+ */
+static double runPattern(Simulator *sim, const Pattern *pattern, int batch,
+                         const CacheConfig *config) {
+  uint32_t value = 0;
+  uint32_t *values = NULL;
+
+  resetTime(sim);
+  initCache(sim);
+
+  if (pattern->chase) {
+    // Store the cycle: the first word of each block holds the next block
+    uint32_t blocks = config->dramSize / config->blockSize;
+    for (uint32_t i = 0; i < blocks; i++) {
+      value = (uint32_t)pattern->addresses[(i + 1) % blocks];
+      write(sim, pattern->addresses[i], (uint8_t *)&value);
+    }
+    initCache(sim);
+  }
+  else if (batch) {
+    values = malloc((size_t)pattern->count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < pattern->count; i++)
+      values[i] = (uint32_t)pattern->addresses[i];
+  }
+
+  double start = nowNs();
+
+  if (pattern->chase) {
+    // DRAM sizes fit a word, so the stored pointers do too
+    uint32_t address = (uint32_t)pattern->addresses[0];
+    for (uint32_t i = 0; i < pattern->count; i++)
+      read(sim, address, (uint8_t *)&address);
+  }
+  else if (batch) {
+    for (uint32_t first = 0; first < pattern->count; first += BATCH_SIZE) {
+      uint32_t n = pattern->count - first < BATCH_SIZE ? pattern->count - first : BATCH_SIZE;
+      accessBatch(sim, &pattern->addresses[first], &pattern->modes[first],
+                  (uint8_t *)&values[first], n);
+    }
+  }
+  else {
+    for (uint32_t i = 0; i < pattern->count; i++)
+      accessL1(sim, pattern->addresses[i], (uint8_t *)&value, pattern->modes[i]);
+  }
+
+  double elapsed = nowNs() - start;
+  free(values);
+  return elapsed / pattern->count;
+}
+
+static double percentile(const double *sorted, uint32_t runs, uint32_t percent) {
+  return sorted[(runs - 1) * percent / 100];
+}
+
+int main(int argc, char **argv) {
+  int json = argc > 1 && strcmp(argv[1], "--json") == 0;
+  uint32_t accesses = argc > 1 + json ? (uint32_t)strtoul(argv[1 + json], NULL, 0)
+                                      : DEFAULT_ACCESSES;
+  uint32_t runs = argc > 2 + json ? (uint32_t)strtoul(argv[2 + json], NULL, 0)
+                                  : DEFAULT_RUNS;
+
+  if (accesses == 0 || runs == 0) {
+    fprintf(stderr, "Usage: %s [--json] [accesses] [runs]\n", argv[0]);
+    return 1;
+  }
+
+  CacheConfig config;
+  modelConfig(&config);
+  Simulator *sim = createSimulator(&config);
+  if (sim == NULL) {
+    fprintf(stderr, "Invalid cache configuration\n");
+    return 1;
+  }
+
+  void (*generators[])(Pattern *, const CacheConfig *) = {
+    sequential, strided, uniform, zipfian, pointerChase, tiledMatmul
+  };
+  const char *names[] = {"sequential", "strided", "uniform", "zipfian", "pointer_chase",
+                         "tiled_matmul"};
+  uint32_t numPatterns = sizeof(names) / sizeof(names[0]);
+  uint32_t blocks = config.dramSize / config.blockSize;
+  uint32_t slots = accesses > blocks ? accesses : blocks;
+  double *samples = malloc(runs * sizeof(double));
+  Pattern pattern = {NULL, malloc(slots * sizeof(uint64_t)), malloc(slots), accesses, 0};
+  int first = 1;
+
+  if (json)
+    printf("[\n");
+  else
+    printf("model,pattern,api,accesses,runs,ns_median,ns_p10,ns_p90,ns_min,ns_max,"
+           "accesses_per_sec\n");
+
+  for (uint32_t p = 0; p < numPatterns; p++) {
+    pattern.name = names[p];
+    pattern.chase = 0;
+    generators[p](&pattern, &config);
+
+    // The chase has no batched form, every address depends on a read
+    for (int batch = 0; batch < 2 - pattern.chase; batch++) {
+      for (uint32_t r = 0; r < runs; r++)
+        samples[r] = runPattern(sim, &pattern, batch, &config);
+      qsort(samples, runs, sizeof(double), compareDoubles);
+
+      double median = percentile(samples, runs, 50);
+      const char *api = batch ? "accessBatch" : "accessL1";
+      const char *layout = json
+          ? "%s  {\"model\": \"%s\", \"pattern\": \"%s\", \"api\": \"%s\", \"accesses\": %u, "
+            "\"runs\": %u, \"ns_median\": %.3f, \"ns_p10\": %.3f, \"ns_p90\": %.3f, "
+            "\"ns_min\": %.3f, \"ns_max\": %.3f, \"accesses_per_sec\": %.0f}"
+          : "%s%s,%s,%s,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.0f\n";
+
+      printf(layout, json && !first ? ",\n" : "", BENCH_MODEL, pattern.name, api, accesses,
+             runs, median, percentile(samples, runs, 10), percentile(samples, runs, 90),
+             samples[0], samples[runs - 1], 1e9 / median);
+      first = 0;
+    }
+  }
+
+  if (json)
+    printf("\n]\n");
+
+  free(samples);
+  free(pattern.addresses);
+  free(pattern.modes);
+  destroySimulator(sim);
+  return 0;
+}
@@ -16,5 +16,17 @@
 #define L2_WRITE_TIME 5
 #define L1_READ_TIME 1
 #define L1_WRITE_TIME 1
+#define L3_READ_TIME 30   // L3 and below, which the default hierarchy does not have
+#define L3_WRITE_TIME 15
+
+#define INVALIDATE_TIME 5 // invalidating other cores' copies on a write miss
+#define UPGRADE_TIME 5    // write hit on a shared line
+#define C2C_TIME 8        // block supplied by another core's L1
+
+#define VICTIM_TIME 3     // block swapped in from the L1 victim buffer
+
+#define L1_MSHRS 8        // outstanding misses per level
+#define L2_MSHRS 16
+#define L3_MSHRS 32
 
 #endif
@@ -0,0 +1,269 @@
+#include <stdlib.h>
+#include <string.h>
+#include "CacheLevel.h"
+
+/**
+ * Function used to allocate a cache level of the given geometry. All lines
+ * start invalid. A tagOnly level keeps metadata only and no block data, and
+ * statsSample sets how often accesses go to the per-set heatmaps.
+ * Levels start write-back, write-allocate, without a prefetcher and
+ * without MSHRs, see initPrefetcher() and initMSHRs().
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int initCacheLevel(CacheLevel *level, uint32_t size, uint32_t blockSize,
+                   uint32_t ways, uint32_t policy, uint32_t readTime,
+                   uint32_t writeTime, int tagOnly, uint32_t statsSample) {
+  uint32_t lines = size / blockSize;
+  // aligned_alloc() wants a multiple of the alignment
+  size_t tagBytes = ((size_t)lines * sizeof(uint64_t) + TAG_ALIGNMENT - 1) &
+                    ~(size_t)(TAG_ALIGNMENT - 1);
+
+  initGeometry(&level->geometry, size, blockSize, ways);
+  level->readTime = readTime;
+  level->writeTime = writeTime;
+  level->writeThrough = 0;
+  level->writeAllocate = 1;
+  level->tags = aligned_alloc(TAG_ALIGNMENT, tagBytes);
+  level->valid = calloc(lines, 1);
+  level->dirty = calloc(lines, 1);
+  level->shared = calloc(lines, 1);
+  level->prefetched = calloc(lines, 1);
+  level->ready = calloc(lines, sizeof(uint64_t));
+  level->data = tagOnly ? NULL : calloc(size, 1);
+
+  if (level->tags == NULL || level->valid == NULL || level->dirty == NULL ||
+      level->shared == NULL || level->prefetched == NULL || level->ready == NULL ||
+      (!tagOnly && level->data == NULL) ||
+      initReplacement(&level->replacement, policy, level->geometry.sets, ways) != 0 ||
+      initPrefetcher(&level->prefetcher, PREFETCH_NONE, 1, 1) != 0 ||
+      initLevelStats(&level->stats, level->geometry.sets, statsSample) != 0) {
+    freeCacheLevel(level);
+    return -1;
+  }
+
+  resetCacheLevel(level);
+  return 0;
+}
+
+/**
+ * Function used to release the arrays of a cache level.
+ */
+void freeCacheLevel(CacheLevel *level) {
+  free(level->tags);
+  free(level->valid);
+  free(level->dirty);
+  free(level->shared);
+  free(level->prefetched);
+  free(level->ready);
+  free(level->data);
+  freeReplacement(&level->replacement);
+  freePrefetcher(&level->prefetcher);
+  free(level->mshrBlocks);
+  free(level->mshrReady);
+  level->mshrBlocks = NULL;
+  level->mshrReady = NULL;
+  level->mshrs = 0;
+  freeLevelStats(&level->stats);
+  level->tags = NULL;
+  level->valid = NULL;
+  level->dirty = NULL;
+  level->shared = NULL;
+  level->prefetched = NULL;
+  level->ready = NULL;
+  level->data = NULL;
+}
+
+/**
+ * Function used to invalidate every line of a cache level. All bits set to 0
+ * and every tag set to INVALID_TAG. The counters start over as well.
+ */
+void resetCacheLevel(CacheLevel *level) {
+  const CacheGeometry *Geometry = &level->geometry;
+  uint32_t lines = Geometry->sets * Geometry->ways;
+
+  for (uint32_t i = 0; i < lines; i++)
+    level->tags[i] = INVALID_TAG;
+  memset(level->valid, 0, lines);
+  memset(level->dirty, 0, lines);
+  memset(level->shared, 0, lines);
+  memset(level->prefetched, 0, lines);
+  memset(level->ready, 0, lines * sizeof(uint64_t));
+  if (level->mshrs != 0)
+    memset(level->mshrReady, 0, level->mshrs * sizeof(uint64_t));
+  if (level->data != NULL)
+    memset(level->data, 0, (size_t)lines * (Geometry->offsetMask + 1));
+  level->validLines = 0;
+  resetReplacement(&level->replacement);
+  resetPrefetcher(&level->prefetcher);
+  resetLevelStats(&level->stats);
+}
+
+/**
+ * Function used to choose the line that receives a missing block: an
+ * invalid way while the level is still filling up, otherwise the way picked
+ * by the replacement policy.
+ */
+uint32_t victimLine(CacheLevel *level, uint64_t address) {
+  const CacheGeometry *Geometry = &level->geometry;
+  uint32_t Index = getIndex(Geometry, address);
+  uint32_t First = Index * Geometry->ways;
+
+  if (level->validLines < Geometry->sets * Geometry->ways) {
+    for (uint32_t i = 0; i < Geometry->ways; i++) {
+      if (!level->valid[First + i])
+        return First + i;
+    }
+  }
+
+  return First + level->replacement.ops->victim(&level->replacement, Index);
+}
+
+/**
+ * Function used to place the block of address in a line returned by
+ * victimLine(). The line is left valid, clean, not shared and not
+ * prefetched.
+ */
+void installLine(CacheLevel *level, uint32_t line, uint64_t address) {
+  uint32_t ways = level->geometry.ways;
+
+  if (!level->valid[line])
+    level->validLines++;
+
+  level->valid[line] = 1;
+  level->dirty[line] = 0;
+  level->shared[line] = 0;
+  level->prefetched[line] = 0;
+  level->tags[line] = getTag(&level->geometry, address);
+  level->replacement.ops->onFill(&level->replacement, line / ways, line % ways);
+}
+
+/**
+ * Function used to drop a line, e.g. when another core writes its block.
+ * Its data is discarded, so dirty lines must be written back or handed over
+ * first. The replacement state is left alone, victimLine() picks invalid
+ * ways first anyway.
+ */
+void invalidateLine(CacheLevel *level, uint32_t line) {
+  if (level->valid[line])
+    level->validLines--;
+
+  level->valid[line] = 0;
+  level->dirty[line] = 0;
+  level->shared[line] = 0;
+  level->prefetched[line] = 0;
+  level->tags[line] = INVALID_TAG;
+}
+
+
+/**************** MSHRs ***************/
+
+/**
+ * Function used to give a level mshrs miss status holding registers, all
+ * free. Levels without MSHRs do not track their misses.
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int initMSHRs(CacheLevel *level, uint32_t mshrs) {
+  level->mshrBlocks = calloc(mshrs, sizeof(uint64_t));
+  level->mshrReady = calloc(mshrs, sizeof(uint64_t));
+  if (level->mshrBlocks == NULL || level->mshrReady == NULL)
+    return -1;
+
+  level->mshrs = mshrs;
+  return 0;
+}
+
+/**
+ * Function used to find the miss in flight at time now for the block of
+ * address. Returns its MSHR or NO_MSHR.
+ */
+uint32_t findMSHR(CacheLevel *level, uint64_t address, uint64_t now) {
+  uint64_t Block = address >> level->geometry.indexShift;
+
+  for (uint32_t i = 0; i < level->mshrs; i++) {
+    if (level->mshrReady[i] > now && level->mshrBlocks[i] == Block)
+      return i;
+  }
+  return NO_MSHR;
+}
+
+/**
+ * Function used to get the first time, now or later, with a free MSHR.
+ */
+uint64_t freeMSHRTime(CacheLevel *level, uint64_t now) {
+  uint64_t First = level->mshrs != 0 ? UINT64_MAX : now;
+
+  for (uint32_t i = 0; i < level->mshrs; i++) {
+    if (level->mshrReady[i] <= now)
+      return now;
+    if (level->mshrReady[i] < First)
+      First = level->mshrReady[i];
+  }
+  return First;
+}
+
+/**
+ * Function used to record a miss fetching the block of address until
+ * ready, in an MSHR free at time now.
+ */
+void allocateMSHR(CacheLevel *level, uint64_t address, uint64_t now, uint64_t ready) {
+  for (uint32_t i = 0; i < level->mshrs; i++) {
+    if (level->mshrReady[i] <= now) {
+      level->mshrBlocks[i] = address >> level->geometry.indexShift;
+      level->mshrReady[i] = ready;
+      return;
+    }
+  }
+}
+
+
+/**************** Checkpoints ***************/
+
+/**
+ * Function used to append the lines of a level, with their blocks, its
+ * MSHRs, replacement state, prefetcher and counters to a checkpoint.
+ * Returns 0 on success and -1 on a write error.
+ */
+int saveCacheLevel(const CacheLevel *level, FILE *file) {
+  size_t Lines = (size_t)level->geometry.sets * level->geometry.ways;
+  size_t Data = level->data != NULL ? Lines << level->geometry.indexShift : 0;
+
+  if (saveBytes(file, level->tags, Lines * sizeof(uint64_t)) != 0 ||
+      saveBytes(file, level->valid, Lines) != 0 || saveBytes(file, level->dirty, Lines) != 0 ||
+      saveBytes(file, level->shared, Lines) != 0 ||
+      saveBytes(file, level->prefetched, Lines) != 0 ||
+      saveBytes(file, level->ready, Lines * sizeof(uint64_t)) != 0 ||
+      saveBytes(file, level->data, Data) != 0 ||
+      saveBytes(file, &level->validLines, sizeof(level->validLines)) != 0 ||
+      saveBytes(file, level->mshrBlocks, level->mshrs * sizeof(uint64_t)) != 0 ||
+      saveBytes(file, level->mshrReady, level->mshrs * sizeof(uint64_t)) != 0 ||
+      saveReplacement(&level->replacement, file) != 0 ||
+      savePrefetcher(&level->prefetcher, file) != 0 || saveLevelStats(&level->stats, file) != 0)
+    return -1;
+  return 0;
+}
+
+/**
+ * Function used to restore the state saved by saveCacheLevel() into a
+ * level of the same configuration.
+ * Returns 0 on success and -1 if the checkpoint is too short.
+ */
+int loadCacheLevel(CacheLevel *level, Snapshot *snapshot) {
+  size_t Lines = (size_t)level->geometry.sets * level->geometry.ways;
+  size_t Data = level->data != NULL ? Lines << level->geometry.indexShift : 0;
+
+  if (loadBytes(snapshot, level->tags, Lines * sizeof(uint64_t)) != 0 ||
+      loadBytes(snapshot, level->valid, Lines) != 0 ||
+      loadBytes(snapshot, level->dirty, Lines) != 0 ||
+      loadBytes(snapshot, level->shared, Lines) != 0 ||
+      loadBytes(snapshot, level->prefetched, Lines) != 0 ||
+      loadBytes(snapshot, level->ready, Lines * sizeof(uint64_t)) != 0 ||
+      loadBytes(snapshot, level->data, Data) != 0 ||
+      loadBytes(snapshot, &level->validLines, sizeof(level->validLines)) != 0 ||
+      loadBytes(snapshot, level->mshrBlocks, level->mshrs * sizeof(uint64_t)) != 0 ||
+      loadBytes(snapshot, level->mshrReady, level->mshrs * sizeof(uint64_t)) != 0 ||
+      loadReplacement(&level->replacement, snapshot) != 0 ||
+      loadPrefetcher(&level->prefetcher, snapshot) != 0 ||
+      loadLevelStats(&level->stats, snapshot) != 0)
+    return -1;
+  return 0;
+}
@@ -0,0 +1,144 @@
+#ifndef CACHELEVEL_H
+#define CACHELEVEL_H
+
+#include <stdint.h>
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+#include "Config.h"
+#include "Replacement.h"
+#include "Prefetch.h"
+#include "Stats.h"
+
+#define NO_LINE UINT32_MAX
+#define NO_MSHR UINT32_MAX
+#define INVALID_TAG UINT64_MAX  // never produced by getTag()
+#define TAG_ALIGNMENT 64        // host cache line, in bytes
+
+/*
+ * One level of the hierarchy: a set-associative array of lines where a
+ * single way is direct-mapped and a single set is fully associative.
+ * Lines are numbered set by set, line = set * ways + way, and their state
+ * is kept in separate arrays so that a lookup only reads the tags of one
+ * set. tags is 64-byte aligned and invalid lines hold INVALID_TAG, so the
+ * ways of a set are compared with a single vector compare. The block of a
+ * line lives at data[line * blockSize]. Tag-only levels have no data array.
+ * Prefetched lines stay marked until their first demand hit, and every
+ * line is ready when its block arrives: hits before that wait for it.
+ * Each MSHR tracks a miss in flight, free again once its block is ready.
+ */
+typedef struct CacheLevel {
+  CacheGeometry geometry;
+  uint64_t *tags;
+  uint8_t *valid;
+  uint8_t *dirty;
+  uint8_t *shared;        // MESI: M dirty, E clean, S shared, I invalid
+  uint8_t *prefetched;
+  uint64_t *ready;
+  uint8_t *data;
+  Replacement replacement;
+  Prefetcher prefetcher;
+  LevelStats stats;
+  uint32_t validLines;
+  uint32_t readTime;
+  uint32_t writeTime;
+  int writeThrough;       // stores also go to the next level, lines stay clean
+  int writeAllocate;      // store misses fetch the block
+  uint32_t mshrs;
+  uint64_t *mshrBlocks;   // address of the block each MSHR fetches
+  uint64_t *mshrReady;
+} CacheLevel;
+
+/*********************** Cache level *************************/
+
+int initCacheLevel(CacheLevel *level, uint32_t size, uint32_t blockSize,
+                   uint32_t ways, uint32_t policy, uint32_t readTime,
+                   uint32_t writeTime, int tagOnly, uint32_t statsSample);
+void freeCacheLevel(CacheLevel *level);
+void resetCacheLevel(CacheLevel *level);
+
+/**
+ * Function used to find the way of a set holding tag, or NO_LINE. Sets of
+ * 4 ways or more are searched 4 tags at a time with AVX2, sets of 2 ways or
+ * more 2 tags at a time with SSE4.1, and the rest with a scalar loop.
+ * Sets are aligned to their own size, so the vector loads are aligned.
+ */
+static inline uint32_t findWay(const uint64_t *set, uint32_t ways, uint64_t tag) {
+  uint32_t i = 0;
+
+#if defined(__AVX2__)
+  if (ways >= 4) {
+    __m256i Key = _mm256_set1_epi64x((long long)tag);
+    for (; i < ways; i += 4) {
+      __m256i Tags = _mm256_load_si256((const __m256i *)&set[i]);
+      int Mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(Tags, Key)));
+      if (Mask != 0)
+        return i + __builtin_ctz(Mask);
+    }
+    return NO_LINE;
+  }
+#endif
+#if defined(__SSE4_1__)
+  if (ways >= 2) {
+    __m128i Key = _mm_set1_epi64x((long long)tag);
+    for (; i < ways; i += 2) {
+      __m128i Tags = _mm_load_si128((const __m128i *)&set[i]);
+      int Mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(Tags, Key)));
+      if (Mask != 0)
+        return i + __builtin_ctz(Mask);
+    }
+    return NO_LINE;
+  }
+#endif
+
+  for (; i < ways; i++) {
+    if (set[i] == tag)
+      return i;
+  }
+  return NO_LINE;
+}
+
+/**
+ * Function used to look up an address. Returns the line holding its block
+ * or NO_LINE on a miss.
+ */
+static inline uint32_t findLine(CacheLevel *level, uint64_t address) {
+  const CacheGeometry *Geometry = &level->geometry;
+  uint32_t First = getIndex(Geometry, address) * Geometry->ways;
+  uint32_t Way = findWay(&level->tags[First], Geometry->ways, getTag(Geometry, address));
+
+  return Way == NO_LINE ? NO_LINE : First + Way;
+}
+
+/**
+ * Function used to get the block stored in a line, or NULL for tag-only
+ * levels.
+ */
+static inline uint8_t *lineData(CacheLevel *level, uint32_t line) {
+  if (level->data == NULL)
+    return NULL;
+  return &level->data[(size_t)line << level->geometry.indexShift];
+}
+
+/**
+ * Function used to tell the replacement policy that a line was hit.
+ */
+static inline void touchLine(CacheLevel *level, uint32_t line) {
+  uint32_t ways = level->geometry.ways;
+
+  level->replacement.ops->onHit(&level->replacement, line / ways, line % ways);
+}
+
+uint32_t victimLine(CacheLevel *level, uint64_t address);
+void installLine(CacheLevel *level, uint32_t line, uint64_t address);
+void invalidateLine(CacheLevel *level, uint32_t line);
+
+int initMSHRs(CacheLevel *level, uint32_t mshrs);
+uint32_t findMSHR(CacheLevel *level, uint64_t address, uint64_t now);
+uint64_t freeMSHRTime(CacheLevel *level, uint64_t now);
+void allocateMSHR(CacheLevel *level, uint64_t address, uint64_t now, uint64_t ready);
+
+int saveCacheLevel(const CacheLevel *level, FILE *file);
+int loadCacheLevel(CacheLevel *level, Snapshot *snapshot);
+
+#endif
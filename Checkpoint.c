@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Simulator.h"
+
+/**************** Checkpoint files ***************/
+
+/**
+ * Function used to save the whole state of a simulator to a checkpoint
+ * file, so that later runs can start from it with loadCheckpoint() instead
+ * of warming the caches again.
+ * Returns 0 on success and -1 on I/O errors.
+ */
+int saveCheckpoint(Simulator *sim, const char *path) {
+  CheckpointHeader Header = {CHECKPOINT_MAGIC, CHECKPOINT_VERSION, sizeof(CacheConfig)};
+  FILE *file = fopen(path, "wb");
+
+  if (file == NULL)
+    return -1;
+
+  if (saveBytes(file, &Header, sizeof(Header)) != 0 || saveSimulator(sim, file) != 0) {
+    fclose(file);
+    return -1;
+  }
+
+  return fclose(file) == 0 ? 0 : -1;
+}
+
+/**
+ * Function used to create a simulator from a checkpoint written by
+ * saveCheckpoint(). The file is mapped and its parts copied straight into
+ * the arrays of the new simulator.
+ * Returns NULL if the file is missing, malformed, has bytes past the saved
+ * state, was saved by a build with a different configuration layout, or
+ * there is not enough memory.
+ */
+Simulator *loadCheckpoint(const char *path) {
+  struct stat st;
+  FILE *file = fopen(path, "rb");
+
+  if (file == NULL)
+    return NULL;
+
+  if (fstat(fileno(file), &st) < 0 || (size_t)st.st_size < sizeof(CheckpointHeader)) {
+    fclose(file);
+    return NULL;
+  }
+
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+  fclose(file);
+  if (map == MAP_FAILED)
+    return NULL;
+
+  Snapshot Snapshot = {map, (const uint8_t *)map + st.st_size};
+  CheckpointHeader Header;
+  Simulator *sim = NULL;
+
+  if (loadBytes(&Snapshot, &Header, sizeof(Header)) == 0 && Header.magic == CHECKPOINT_MAGIC &&
+      Header.version == CHECKPOINT_VERSION && Header.configSize == sizeof(CacheConfig))
+    sim = loadSimulator(&Snapshot);
+
+  if (sim != NULL && Snapshot.next != Snapshot.end) {
+    destroySimulator(sim);
+    sim = NULL;
+  }
+
+  munmap(map, st.st_size);
+  return sim;
+}
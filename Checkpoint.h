@@ -0,0 +1,54 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Checkpoint file layout:
+ *   CheckpointHeader  (16 bytes)
+ *   CacheConfig of the simulator
+ *   state of every part of the simulator, in a fixed order
+ * Each part saves its own fields and arrays, whose sizes follow from the
+ * configuration. All fields are stored in host byte order.
+ */
+#define CHECKPOINT_MAGIC 0x504B4843 // "CHKP"
+#define CHECKPOINT_VERSION 1
+
+typedef struct CheckpointHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t configSize;  // sizeof(CacheConfig) of the build that saved it
+} CheckpointHeader;
+
+/*
+ * Position in a mapped checkpoint being loaded.
+ */
+typedef struct Snapshot {
+  const uint8_t *next;
+  const uint8_t *end;
+} Snapshot;
+
+/**
+ * Function used to append size bytes to a checkpoint.
+ * Returns 0 on success and -1 if they can't be written.
+ */
+static inline int saveBytes(FILE *file, const void *data, size_t size) {
+  return size == 0 || fwrite(data, size, 1, file) == 1 ? 0 : -1;
+}
+
+/**
+ * Function used to read the next size bytes of a checkpoint into data.
+ * Returns 0 on success and -1 past the end of the checkpoint.
+ */
+static inline int loadBytes(Snapshot *snapshot, void *data, size_t size) {
+  if ((size_t)(snapshot->end - snapshot->next) < size)
+    return -1;
+  if (size != 0)
+    memcpy(data, snapshot->next, size);
+  snapshot->next += size;
+  return 0;
+}
+
+#endif
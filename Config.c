@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "Config.h"
+#include "Replacement.h"
+#include "Prefetch.h"
+
+#define OPTION_NUMBER 0
+#define OPTION_POLICY 1       // also given by name, e.g. "drrip"
+#define OPTION_PREFETCHER 2   // also given by name, e.g. "stride"
+#define OPTION_INCLUSION 3    // also given by name, e.g. "exclusive"
+
+typedef struct ConfigOption {
+  const char *name;
+  size_t offset;
+  int kind;
+} ConfigOption;
+
+#define LEVEL_OPTIONS(name, i) \
+  {name "_size", offsetof(CacheConfig, levels[i].size), OPTION_NUMBER}, \
+  {name "_ways", offsetof(CacheConfig, levels[i].ways), OPTION_NUMBER}, \
+  {name "_policy", offsetof(CacheConfig, levels[i].policy), OPTION_POLICY}, \
+  {name "_prefetcher", offsetof(CacheConfig, levels[i].prefetcher), OPTION_PREFETCHER}, \
+  {name "_read_time", offsetof(CacheConfig, levels[i].readTime), OPTION_NUMBER}, \
+  {name "_write_time", offsetof(CacheConfig, levels[i].writeTime), OPTION_NUMBER}, \
+  {name "_write_through", offsetof(CacheConfig, levels[i].writeThrough), OPTION_NUMBER}, \
+  {name "_write_allocate", offsetof(CacheConfig, levels[i].writeAllocate), OPTION_NUMBER}, \
+  {name "_mshrs", offsetof(CacheConfig, levels[i].mshrs), OPTION_NUMBER}
+
+// One LEVEL_OPTIONS per level up to MAX_LEVELS. The L1 has nothing above
+// it, so no inclusion.
+static const ConfigOption Options[] = {
+  {"block_size", offsetof(CacheConfig, blockSize), OPTION_NUMBER},
+  {"dram_size", offsetof(CacheConfig, dramSize), OPTION_NUMBER},
+  LEVEL_OPTIONS("l1", 0),
+  LEVEL_OPTIONS("l2", 1),
+  {"l2_inclusion", offsetof(CacheConfig, levels[1].inclusion), OPTION_INCLUSION},
+  LEVEL_OPTIONS("l3", 2),
+  {"l3_inclusion", offsetof(CacheConfig, levels[2].inclusion), OPTION_INCLUSION},
+  LEVEL_OPTIONS("l4", 3),
+  {"l4_inclusion", offsetof(CacheConfig, levels[3].inclusion), OPTION_INCLUSION},
+  {"prefetch_degree", offsetof(CacheConfig, prefetchDegree), OPTION_NUMBER},
+  {"prefetch_distance", offsetof(CacheConfig, prefetchDistance), OPTION_NUMBER},
+  {"write_buffer_entries", offsetof(CacheConfig, writeBufferEntries), OPTION_NUMBER},
+  {"dram_read_time", offsetof(CacheConfig, dramReadTime), OPTION_NUMBER},
+  {"dram_write_time", offsetof(CacheConfig, dramWriteTime), OPTION_NUMBER},
+  {"victim_entries", offsetof(CacheConfig, victimEntries), OPTION_NUMBER},
+  {"victim_time", offsetof(CacheConfig, victimTime), OPTION_NUMBER},
+  {"cores", offsetof(CacheConfig, cores), OPTION_NUMBER},
+  {"quantum", offsetof(CacheConfig, quantum), OPTION_NUMBER},
+  {"invalidate_time", offsetof(CacheConfig, invalidateTime), OPTION_NUMBER},
+  {"upgrade_time", offsetof(CacheConfig, upgradeTime), OPTION_NUMBER},
+  {"c2c_time", offsetof(CacheConfig, c2cTime), OPTION_NUMBER},
+  {"tag_only", offsetof(CacheConfig, tagOnly), OPTION_NUMBER},
+  {"stats_sample", offsetof(CacheConfig, statsSample), OPTION_NUMBER},
+};
+
+
+#define NUM_OPTIONS (sizeof(Options) / sizeof(Options[0]))
+
+static const char *const Inclusions[NUM_INCLUSIONS] = {"nine", "inclusive", "exclusive"};
+
+static int parseInclusionName(const char *name) {
+  for (int i = 0; i < NUM_INCLUSIONS; i++) {
+    if (strcmp(Inclusions[i], name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+static int isPowerOfTwo(uint32_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+static int log2i(uint32_t value) {
+  int bits = 0;
+  while (value >>= 1)
+    bits++;
+  return bits;
+}
+
+/**
+ * Function used to fill a configuration with the defaults from Cache.h: an
+ * L1 and an L2, both direct-mapped and write-back. The levels below them
+ * are left out but get the L3 latencies, so setting their size is enough
+ * to add them.
+ */
+void defaultConfig(CacheConfig *config) {
+  config->blockSize = BLOCK_SIZE;
+  config->dramSize = DRAM_SIZE;
+
+  for (uint32_t i = 0; i < MAX_LEVELS; i++) {
+    LevelConfig *Level = &config->levels[i];
+
+    Level->size = i == 0 ? L1_SIZE : i == 1 ? L2_SIZE : 0;
+    Level->ways = 1;
+    Level->policy = POLICY_LRU;
+    Level->prefetcher = PREFETCH_NONE;
+    Level->readTime = i == 0 ? L1_READ_TIME : i == 1 ? L2_READ_TIME : L3_READ_TIME;
+    Level->writeTime = i == 0 ? L1_WRITE_TIME : i == 1 ? L2_WRITE_TIME : L3_WRITE_TIME;
+    Level->writeThrough = 0;
+    Level->writeAllocate = 1;
+    Level->mshrs = i == 0 ? L1_MSHRS : i == 1 ? L2_MSHRS : L3_MSHRS;
+    Level->inclusion = INCLUSION_NINE;
+  }
+
+  config->prefetchDegree = 1;
+  config->prefetchDistance = 1;
+  config->writeBufferEntries = 0;
+
+  config->dramReadTime = DRAM_READ_TIME;
+  config->dramWriteTime = DRAM_WRITE_TIME;
+
+  config->victimEntries = 0;
+  config->victimTime = VICTIM_TIME;
+
+  config->cores = 1;
+  config->quantum = 1;
+  config->invalidateTime = INVALIDATE_TIME;
+  config->upgradeTime = UPGRADE_TIME;
+  config->c2cTime = C2C_TIME;
+
+  config->tagOnly = 0;
+  config->statsSample = 1;
+}
+
+/**
+ * Function used to count the cache levels of a configuration, up to the
+ * first one of size 0.
+ */
+uint32_t configLevels(const CacheConfig *config) {
+  uint32_t i = 0;
+
+  while (i < MAX_LEVELS && config->levels[i].size != 0)
+    i++;
+  return i;
+}
+
+/**
+ * Function used to set a single option by name, e.g. ("l2_ways", "4").
+ * Policies, prefetchers and inclusion are given by name, e.g. ("l2_policy",
+ * "drrip").
+ * Returns 0 on success and -1 for unknown options or malformed values.
+ */
+int parseConfigOption(CacheConfig *config, const char *key, const char *value) {
+  char *end;
+  unsigned long parsed = strtoul(value, &end, 0);
+
+  for (size_t i = 0; i < NUM_OPTIONS; i++) {
+    if (strcmp(Options[i].name, key) != 0)
+      continue;
+
+    int named = Options[i].kind == OPTION_POLICY ? parsePolicyName(value) :
+                Options[i].kind == OPTION_PREFETCHER ? parsePrefetcherName(value) :
+                Options[i].kind == OPTION_INCLUSION ? parseInclusionName(value) : -1;
+    if (named >= 0)
+      parsed = named;
+    else if (end == value || *end != '\0' || parsed > UINT32_MAX)
+      return -1;
+
+    *(uint32_t *)((char *)config + Options[i].offset) = (uint32_t)parsed;
+    return 0;
+  }
+  return -1;
+}
+
+/**
+ * Function used to override a configuration with the "key = value" lines
+ * of a file. Empty lines and lines starting with '#' are ignored.
+ * Returns 0 on success and -1 if the file can't be read or has errors.
+ */
+int loadConfig(const char *path, CacheConfig *config) {
+  char line[256], key[64], value[64];
+  int lineNumber = 0, result = 0;
+  FILE *file = fopen(path, "r");
+
+  if (file == NULL)
+    return -1;
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    lineNumber++;
+
+    char *start = line + strspn(line, " \t");
+    if (*start == '#' || *start == '\n' || *start == '\0')
+      continue;
+
+    if (sscanf(start, " %63[^= \t] = %63s", key, value) != 2 ||
+        parseConfigOption(config, key, value) != 0) {
+      fprintf(stderr, "%s:%d: invalid option\n", path, lineNumber);
+      result = -1;
+    }
+  }
+
+  fclose(file);
+  return result;
+}
+
+/**
+ * Function used to get the name of the i-th option, or NULL past the last
+ * one. Used to print a whole configuration.
+ */
+const char *configOptionName(size_t i) {
+  return i < NUM_OPTIONS ? Options[i].name : NULL;
+}
+
+/**
+ * Function used to format the value of the i-th option of a configuration
+ * the way parseConfigOption() reads it back.
+ */
+void formatConfigOption(const CacheConfig *config, size_t i, char *buffer, size_t size) {
+  uint32_t value = *(const uint32_t *)((const char *)config + Options[i].offset);
+
+  if (Options[i].kind == OPTION_POLICY && value < NUM_POLICIES)
+    snprintf(buffer, size, "%s", policyName(value));
+  else if (Options[i].kind == OPTION_PREFETCHER && value < NUM_PREFETCHERS)
+    snprintf(buffer, size, "%s", prefetcherName(value));
+  else if (Options[i].kind == OPTION_INCLUSION && value < NUM_INCLUSIONS)
+    snprintf(buffer, size, "%s", Inclusions[value]);
+  else
+    snprintf(buffer, size, "%u", value);
+}
+
+/**
+ * Function used to check that a cache level is buildable: power of two
+ * sizes, whole sets and at most MAX_MSHRS misses in flight.
+ */
+static int validateLevel(const LevelConfig *level, uint32_t blockSize) {
+  if (!isPowerOfTwo(level->size) || !isPowerOfTwo(level->ways) ||
+      level->size < blockSize * level->ways || level->policy >= NUM_POLICIES ||
+      level->prefetcher >= NUM_PREFETCHERS || level->inclusion >= NUM_INCLUSIONS)
+    return -1;
+
+  if (level->mshrs == 0 || level->mshrs > MAX_MSHRS)
+    return -1;
+  return 0;
+}
+
+/**
+ * Function used to check that a configuration describes a buildable
+ * hierarchy: valid levels with nothing listed after the first one of size
+ * 0, and a block size that fits the word interface. Several cores need a
+ * shared level below their L1s. The victim buffer holds a power of two
+ * entries, and like the write buffer and L1 store misses that bypass the
+ * L1 it is single-core only. An exclusive level needs a write-back level
+ * above it and no prefetcher, since it only ever receives that level's
+ * victims. Below the L1 this also means a single core and no victim
+ * buffer.
+ * Returns 0 if the configuration is valid and -1 otherwise.
+ */
+int validateConfig(const CacheConfig *config) {
+  uint32_t levels = configLevels(config);
+
+  if (!isPowerOfTwo(config->blockSize) || config->blockSize < WORD_SIZE ||
+      config->blockSize > MAX_BLOCK_SIZE)
+    return -1;
+
+  if (config->dramSize < config->blockSize || config->dramSize % config->blockSize != 0)
+    return -1;
+
+  if (levels == 0 || config->levels[0].inclusion != INCLUSION_NINE)
+    return -1;
+
+  for (uint32_t i = 0; i < MAX_LEVELS; i++) {
+    const LevelConfig *Level = &config->levels[i];
+
+    if (i >= levels) {
+      if (Level->size != 0)
+        return -1;
+      continue;
+    }
+    if (validateLevel(Level, config->blockSize) != 0)
+      return -1;
+
+    if (Level->inclusion == INCLUSION_EXCLUSIVE &&
+        (config->levels[i - 1].writeThrough || Level->prefetcher != PREFETCH_NONE ||
+         (i == 1 && (config->cores > 1 || config->victimEntries != 0))))
+      return -1;
+  }
+
+  if (config->prefetchDegree == 0 || config->prefetchDegree > MAX_PREFETCH_DEGREE ||
+      config->prefetchDistance == 0)
+    return -1;
+
+  if (config->victimEntries != 0 &&
+      (!isPowerOfTwo(config->victimEntries) || config->cores > 1))
+    return -1;
+
+  if (config->cores > 1 && (config->writeBufferEntries != 0 ||
+                            !config->levels[0].writeAllocate))
+    return -1;
+
+  if (config->cores == 0 || config->cores > MAX_CORES || config->quantum == 0 ||
+      (config->cores > 1 && levels == 1))
+    return -1;
+
+  return 0;
+}
+
+/**
+ * Function used to precompute the shifts and masks that split an address
+ * into tag, index and offset for a cache of the given geometry.
+ */
+void initGeometry(CacheGeometry *geometry, uint32_t size, uint32_t blockSize,
+                  uint32_t ways) {
+  geometry->ways = ways;
+  geometry->sets = size / blockSize / ways;
+  geometry->offsetMask = blockSize - 1;
+  geometry->indexMask = geometry->sets - 1;
+  geometry->indexShift = log2i(blockSize);
+  geometry->tagShift = geometry->indexShift + log2i(geometry->sets);
+}
@@ -0,0 +1,120 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Cache.h"
+
+#define MAX_BLOCK_SIZE 4096 // in bytes
+#define MAX_CORES 16
+#define MAX_MSHRS 64
+#define MAX_LEVELS 4        // cache levels, DRAM not included
+
+#define INCLUSION_NINE 0       // non-inclusive non-exclusive, the default
+#define INCLUSION_INCLUSIVE 1  // the level holds every block of the ones above
+#define INCLUSION_EXCLUSIVE 2  // the level only holds the victims of the one above
+#define NUM_INCLUSIONS 3
+
+/*
+ * One cache level. Level 0 is the L1, private to each core, the levels
+ * after it are shared.
+ */
+typedef struct LevelConfig {
+  uint32_t size;          // in bytes, 0: no such level
+  uint32_t ways;
+  uint32_t policy;        // POLICY_* from Replacement.h
+  uint32_t prefetcher;    // PREFETCH_* from Prefetch.h
+  uint32_t readTime;
+  uint32_t writeTime;
+  uint32_t writeThrough;  // 0: write-back
+  uint32_t writeAllocate; // 0: store misses bypass the level
+  uint32_t mshrs;         // misses kept in flight
+  uint32_t inclusion;     // INCLUSION_* towards the levels above
+} LevelConfig;
+
+/*
+ * Geometry and latencies of a hierarchy. The defaults come from Cache.h and
+ * can be overridden at runtime with loadConfig() or parseConfigOption().
+ * The cache levels are listed from the L1 down, the first one of size 0
+ * ends the list and DRAM comes after the last one.
+ * The simulated DRAM is sparse and covers the whole 64-bit address space,
+ * dramSize only bounds the addresses of benchmarks and analyses.
+ */
+typedef struct CacheConfig {
+  uint32_t blockSize;     // in bytes
+  uint32_t dramSize;      // in bytes, footprint of generated workloads only
+  LevelConfig levels[MAX_LEVELS];
+  uint32_t prefetchDegree;    // blocks fetched per trigger
+  uint32_t prefetchDistance;  // blocks between the trigger and the first one
+  uint32_t writeBufferEntries;  // coalescing buffer behind the L1, 0: none
+
+  uint32_t dramReadTime;
+  uint32_t dramWriteTime;
+
+  uint32_t victimEntries;  // fully associative buffer behind the L1, 0: none
+  uint32_t victimTime;
+
+  uint32_t cores;         // private L1s kept coherent with MESI, shared levels
+  uint32_t quantum;       // records per core per turn when interleaving
+  uint32_t invalidateTime;
+  uint32_t upgradeTime;
+  uint32_t c2cTime;
+
+  uint32_t tagOnly;       // 1: track tags and timing only, no data or DRAM
+  uint32_t statsSample;   // per-set heatmaps count 1 in N accesses, 0: off
+} CacheConfig;
+
+/*
+ * Address decoding of one cache level, precomputed once so that splitting
+ * an address costs only shifts and ANDs.
+ */
+typedef struct CacheGeometry {
+  uint32_t sets;
+  uint32_t ways;
+  uint32_t offsetMask;
+  uint32_t indexMask;
+  int indexShift;
+  int tagShift;
+} CacheGeometry;
+
+/*********************** Configuration *************************/
+
+void defaultConfig(CacheConfig *config);
+uint32_t configLevels(const CacheConfig *config);
+int parseConfigOption(CacheConfig *config, const char *key, const char *value);
+int loadConfig(const char *path, CacheConfig *config);
+int validateConfig(const CacheConfig *config);
+
+const char *configOptionName(size_t i);
+void formatConfigOption(const CacheConfig *config, size_t i, char *buffer, size_t size);
+
+void initGeometry(CacheGeometry *geometry, uint32_t size, uint32_t blockSize,
+                  uint32_t ways);
+
+/*********************** Address decoding *************************/
+
+static inline uint32_t getOffset(const CacheGeometry *geometry, uint64_t address) {
+  return address & geometry->offsetMask;
+}
+
+static inline uint32_t getIndex(const CacheGeometry *geometry, uint64_t address) {
+  return (address >> geometry->indexShift) & geometry->indexMask;
+}
+
+static inline uint64_t getTag(const CacheGeometry *geometry, uint64_t address) {
+  return address >> geometry->tagShift;
+}
+
+/**
+ * Function to obtain the RAM address where the cache block (that is being
+ * replaced) belongs to.
+ * We use the tag (saved in cache) and the index (got from the new address).
+ */
+static inline uint64_t getOldAddress(const CacheGeometry *geometry,
+                                     uint64_t address, uint64_t tag) {
+  uint64_t addressWithoutTag = address & (((uint64_t)geometry->indexMask << geometry->indexShift) |
+                                          geometry->offsetMask);
+  return (tag << geometry->tagShift) | addressWithoutTag;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <string.h>
+#include "TraceImport.h"
+
+/**
+ * Function used to copy a native trace a piece at a time, e.g. to pack or
+ * unpack it.
+ * Returns 0 on success, -1 if the input is malformed and -2 if the output
+ * can't be written.
+ */
+static int copyTrace(const Trace *trace, const char *output, int packed, uint64_t *count) {
+  TraceWriter writer;
+  TraceCursor cursor;
+  const TraceRecord *records;
+  uint64_t n;
+  int status = 0;
+
+  if (openTraceCursor(trace, &cursor) != 0)
+    return -2;
+  if (openTraceWriter(output, packed, &writer) != 0) {
+    closeTraceCursor(&cursor);
+    return -2;
+  }
+
+  while (status == 0 && (n = nextRecords(&cursor, UINT64_MAX, &records)) > 0)
+    status = appendRecords(&writer, records, n) != 0 ? -2 : 0;
+  if (status == 0 && cursor.failed)
+    status = -1;
+
+  *count = writer.count;
+  if (closeTraceWriter(&writer) != 0)
+    status = -2;
+  closeTraceCursor(&cursor);
+  return status;
+}
+
+int main(int argc, char **argv) {
+  int format = IMPORT_AUTO, instructions = 0, packed = 0;
+  const char *program = argv[0];
+
+  // Options come before the input file
+  for (; argc > 1 && strncmp(argv[1], "--", 2) == 0; argc--, argv++) {
+    if (strncmp(argv[1], "--format=", 9) == 0 && (format = parseImportFormat(argv[1] + 9)) >= 0)
+      continue;
+    if (strcmp(argv[1], "--instructions") == 0) {
+      instructions = 1;
+      continue;
+    }
+    if (strcmp(argv[1], "--packed") == 0) {
+      packed = 1;
+      continue;
+    }
+    argc = 0;
+    break;
+  }
+
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s [--format=auto|din|lackey|champsim] [--instructions] [--packed] "
+                    "<input trace[.gz|.xz]> <output trace>\n", program);
+    return 1;
+  }
+
+  // Native traces, packed or not, are copied in the other layout
+  uint64_t count = 0;
+  Trace trace;
+  int status;
+  if (format == IMPORT_AUTO && openTrace(argv[1], &trace) == 0) {
+    status = copyTrace(&trace, argv[2], packed, &count);
+    closeTrace(&trace);
+  }
+  else {
+    status = importTrace(argv[1], format, instructions, argv[2], packed, &count);
+  }
+
+  if (status != 0) {
+    if (status == -1)
+      fprintf(stderr, "Could not read %s after %llu records\n", argv[1],
+              (unsigned long long)count);
+    else
+      fprintf(stderr, "Could not write %s\n", argv[2]);
+    remove(argv[2]);
+    return 1;
+  }
+
+  printf("Records: %llu\n", (unsigned long long)count);
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include "EventQueue.h"
+
+#define INITIAL_EVENTS 64
+
+static int before(const Event *a, const Event *b) {
+  return a->time < b->time || (a->time == b->time && a->id < b->id);
+}
+
+/**
+ * Function used to set up an empty event queue.
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int initEventQueue(EventQueue *queue) {
+  queue->count = 0;
+  queue->capacity = INITIAL_EVENTS;
+  queue->events = malloc(INITIAL_EVENTS * sizeof(Event));
+  return queue->events != NULL ? 0 : -1;
+}
+
+/**
+ * Function used to release the events of a queue.
+ */
+void freeEventQueue(EventQueue *queue) {
+  free(queue->events);
+  queue->events = NULL;
+  queue->count = 0;
+  queue->capacity = 0;
+}
+
+/**
+ * Function used to drop every pending event.
+ */
+void resetEventQueue(EventQueue *queue) {
+  queue->count = 0;
+}
+
+/**
+ * Function used to make room for one more event, so that the next
+ * pushEvent() cannot fail.
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int reserveEvent(EventQueue *queue) {
+  if (queue->count == queue->capacity) {
+    Event *events = realloc(queue->events, 2 * (size_t)queue->capacity * sizeof(Event));
+    if (events == NULL)
+      return -1;
+    queue->events = events;
+    queue->capacity *= 2;
+  }
+  return 0;
+}
+
+/**
+ * Function used to add an event, sifting it up to its place.
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int pushEvent(EventQueue *queue, uint64_t time, uint64_t id) {
+  if (reserveEvent(queue) != 0)
+    return -1;
+
+  Event event = {time, id};
+  uint32_t i = queue->count++;
+
+  while (i > 0 && before(&event, &queue->events[(i - 1) / 2])) {
+    queue->events[i] = queue->events[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  queue->events[i] = event;
+  return 0;
+}
+
+/**
+ * Function used to take the earliest event out of the queue.
+ * Returns 0 on success and -1 if the queue is empty.
+ */
+int popEvent(EventQueue *queue, Event *event) {
+  if (queue->count == 0)
+    return -1;
+
+  *event = queue->events[0];
+  Event last = queue->events[--queue->count];
+  uint32_t i = 0;
+
+  for (;;) {
+    uint32_t child = 2 * i + 1;
+    if (child >= queue->count)
+      break;
+    if (child + 1 < queue->count && before(&queue->events[child + 1], &queue->events[child]))
+      child++;
+    if (!before(&queue->events[child], &last))
+      break;
+    queue->events[i] = queue->events[child];
+    i = child;
+  }
+  queue->events[i] = last;
+  return 0;
+}
+
+/**
+ * Function used to append the pending events of a queue to a checkpoint.
+ * Returns 0 on success and -1 on a write error.
+ */
+int saveEventQueue(const EventQueue *queue, FILE *file) {
+  if (saveBytes(file, &queue->count, sizeof(queue->count)) != 0 ||
+      saveBytes(file, queue->events, queue->count * sizeof(Event)) != 0)
+    return -1;
+  return 0;
+}
+
+/**
+ * Function used to add the events saved by saveEventQueue() to a queue.
+ * Returns 0 on success and -1 if the checkpoint is too short or there is
+ * not enough memory.
+ */
+int loadEventQueue(EventQueue *queue, Snapshot *snapshot) {
+  uint32_t Count;
+  Event Pending;
+
+  if (loadBytes(snapshot, &Count, sizeof(Count)) != 0)
+    return -1;
+
+  while (Count-- > 0) {
+    if (loadBytes(snapshot, &Pending, sizeof(Pending)) != 0 ||
+        pushEvent(queue, Pending.time, Pending.id) != 0)
+      return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <stdint.h>
+#include "Checkpoint.h"
+
+/*
+ * An event: something identified by id happens at time.
+ */
+typedef struct Event {
+  uint64_t time;
+  uint64_t id;
+} Event;
+
+/*
+ * Binary min-heap of events ordered by time, then by id, so events due at
+ * the same time come out in the order of their ids. Grows as needed.
+ */
+typedef struct EventQueue {
+  Event *events;
+  uint32_t count;
+  uint32_t capacity;
+} EventQueue;
+
+/*********************** Event queue *************************/
+
+int initEventQueue(EventQueue *queue);
+void freeEventQueue(EventQueue *queue);
+void resetEventQueue(EventQueue *queue);
+
+int reserveEvent(EventQueue *queue);
+int pushEvent(EventQueue *queue, uint64_t time, uint64_t id);
+int popEvent(EventQueue *queue, Event *event);
+
+int saveEventQueue(const EventQueue *queue, FILE *file);
+int loadEventQueue(EventQueue *queue, Snapshot *snapshot);
+
+#endif
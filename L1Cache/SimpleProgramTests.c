@@ -1,4 +1,7 @@
 #include "L1Cache.h"
+#include "../StackDistance.h"
+#include "../Trace.h"
+#include "../TraceImport.h"
 
 uint32_t createAddress(uint32_t tag, uint32_t index, uint32_t offset) {
   return ((tag << 14) | (index << 6) | offset);
@@ -13,31 +16,32 @@ void test0() {
   int clock1, clock2, diff;
   long int total;
 
-  resetTime();
-  initCache();
+  Simulator *sim = createSimulator(NULL);
+  resetTime(sim);
+  initCache(sim);
 
   value = 4;
   total = 0;
 
   // Apenas coloca o valor 4 na RAM para futuros acessos
   address = 0x00008000;
-  accessDRAM(address, &value, MODE_WRITE);
+  accessDRAM(sim, address, &value, MODE_WRITE);
   address = 0x00000000;
-  accessDRAM(address, &value, MODE_WRITE);
+  accessDRAM(sim, address, &value, MODE_WRITE);
 
 
   value = 8;
-  clock1 = getTime();
-  write(address, &value);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  write(sim, address, &value);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d\n", diff);
 
 
-  clock1 = getTime();
-  read(address, &res);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  read(sim, address, &res);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d | Valor obtido: %d, Valor Correto: 8\n", diff, res);
@@ -45,32 +49,33 @@ void test0() {
 
   value = 6;
   address = 0x00008000;
-  clock1 = getTime();
-  write(address, &value);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  write(sim, address, &value);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d\n", diff);
 
 
   address = 0x00000000;
-  clock1 = getTime();
-  read(address, &res);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  read(sim, address, &res);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d | Valor obtido: %d, Valor Correto: 8\n", diff, res);
 
 
   address = 0x00008000;
-  clock1 = getTime();
-  read(address, &res);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  read(sim, address, &res);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d | Valor obtido: %d, Valor Correto: 6\n", diff, res);
 
   printf("Tempo Total em Operações: %ld\n", total);
+  destroySimulator(sim);
 }
 
 
@@ -79,58 +84,60 @@ void test1() {
     
     int clock_previous = 0, value;
   
-    resetTime();
-    initCache();
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
 
     // Read on (0, 0, 0) -> Load from DRAM (100+10+1)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 0, 1) -> Load from L1 (1)
-    read(createAddress(0, 0, 1), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 1), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 1, 4) -> Load from DRAM (100+10+1)
-    read(createAddress(0, 1, 4), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 1, 4), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (1, 0, 0) -> Load from DRAM (100+10+1)
-    read(createAddress(1, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (1, 0, 1) -> Load from L1 (1)
-    read(createAddress(1, 0, 1), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(1, 0, 1), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 0, 0) -> Load from L2 (10+1)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (2, 0, 0) -> Load from DRAM (111)
-    read(createAddress(2, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(2, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (1, 0, 0) -> Load from L2 (11)
-    read(createAddress(1, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (3, 0, 0) -> Load from DRAM (111)
-    read(createAddress(3, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(3, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 0, 0) -> Load from DRAM (111)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
+    destroySimulator(sim);
 }
 
 void test2() {
@@ -138,33 +145,305 @@ void test2() {
     
     int clock_previous = 0, value;
   
-    resetTime();
-    initCache();
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
 
     // Read on (0, 0, 0) -> Load from DRAM (111)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (1, 0, 0) -> Load from DRAM (111)
-    read(createAddress(1, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (2, 0, 0) -> Load from DRAM (111)
-    read(createAddress(2, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(2, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 0, 0) -> Load from L2 (11)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
+    destroySimulator(sim);
 }
 
 
+void test3() {
+    printf("-------- TEST 3 --------\n");
+
+    // Same block accessed twice, then a block that aliases on index 0
+    TraceRecord records[3] = {
+      {createAddress(0, 0, 0), MODE_WRITE, WORD_SIZE, {0}},
+      {createAddress(0, 0, 4), MODE_READ, WORD_SIZE, {0}},
+      {createAddress(1, 0, 0), MODE_READ, WORD_SIZE, {0}},
+    };
+    Trace trace;
+    int value = 0;
+
+    writeTrace("/tmp/SimpleProgramTests.trace", records, 3);
+    if (openTrace("/tmp/SimpleProgramTests.trace", &trace) != 0) {
+      printf("Could not open trace\n");
+      return;
+    }
+
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
+
+    for (uint64_t i = 0; i < trace.count; i++) {
+      if (trace.records[i].mode == MODE_READ)
+        read(sim, trace.records[i].address, (unsigned char *)(&value));
+      else
+        write(sim, trace.records[i].address, (unsigned char *)(&value));
+    }
+
+    // Miss (100+1), hit (1), miss with dirty write back (50+100+1)
+    printf("Records: %llu | Time: %d, Correct Time: 253\n",
+           (unsigned long long)trace.count, (int)getTime(sim));
+
+    closeTrace(&trace);
+    destroySimulator(sim);
+}
+
+
+void test4() {
+    printf("-------- TEST 4 --------\n");
+
+    int value = 7, res = 0;
+    Simulator *simA = createSimulator(NULL);
+    Simulator *simB = createSimulator(NULL);
+
+    resetTime(simA);
+    initCache(simA);
+    resetTime(simB);
+    initCache(simB);
+
+    // Only simA sees the write, simB keeps its own DRAM, caches and time
+    write(simA, createAddress(0, 0, 0), (unsigned char *)(&value));
+    read(simB, createAddress(0, 0, 0), (unsigned char *)(&res));
+
+    printf("Time A: %d, Time B: %d | Valor obtido: %d, Valor Correto: 0\n",
+           (int)getTime(simA), (int)getTime(simB), res);
+
+    destroySimulator(simA);
+    destroySimulator(simB);
+}
+
+void test5() {
+    printf("-------- TEST 5 --------\n");
+
+    // Write, two hits on the same block, a conflict miss that writes it
+    // back and a miss that brings it back from DRAM
+    uint64_t addresses[5] = {createAddress(0, 0, 0), createAddress(0, 0, 0),
+                             createAddress(0, 0, 4), createAddress(1, 0, 0),
+                             createAddress(0, 0, 0)};
+    uint8_t modes[5] = {MODE_WRITE, MODE_READ, MODE_READ, MODE_READ, MODE_READ};
+    uint32_t values[5] = {5, 0, 0, 0, 0}, value = 5;
+    Simulator *simA = createSimulator(NULL);
+    Simulator *simB = createSimulator(NULL);
+
+    resetTime(simA);
+    initCache(simA);
+    resetTime(simB);
+    initCache(simB);
+
+    for (int i = 0; i < 5; i++) {
+      if (modes[i] == MODE_READ)
+        read(simB, addresses[i], (unsigned char *)(&value));
+      else
+        write(simB, addresses[i], (unsigned char *)(&value));
+    }
+
+    uint64_t time = accessBatch(simA, addresses, modes, (uint8_t *)values, 5);
+
+    printf("Time: %d, Correct Time: %d | Valor obtido: %d, Valor Correto: 5\n",
+           (int)time, (int)getTime(simB), values[4]);
+
+    destroySimulator(simA);
+    destroySimulator(simB);
+}
+
+void test6() {
+    printf("-------- TEST 6 --------\n");
+
+    // Tags 0, 1, 0 on one L1 set: the direct-mapped L1 misses the second
+    // access to tag 0, a 2-way cache of the same number of sets hits it
+    StackDistance *stack = createStackDistance(BLOCK_SIZE, L1_SIZE / BLOCK_SIZE);
+
+    recordAccess(stack, createAddress(0, 0, 0));
+    recordAccess(stack, createAddress(1, 0, 0));
+    recordAccess(stack, createAddress(0, 0, 4));
+
+    printf("Hits 1 way: %llu, Correct Hits: 0 | Hits 2 ways: %llu, Correct Hits: 1\n",
+           (unsigned long long)stackHits(stack, L1_SIZE / BLOCK_SIZE, 1),
+           (unsigned long long)stackHits(stack, L1_SIZE / BLOCK_SIZE, 2));
+
+    destroyStackDistance(stack);
+}
+
+void test7() {
+    printf("-------- TEST 7 --------\n");
+
+    int clock_previous, value = 7, res = 0;
+    CacheConfig config;
+    modelConfig(&config);
+    config.victimEntries = 4;
+
+    Simulator *sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+
+    // Tags 0 and 1 on index 0 thrash the direct-mapped L1, the victim
+    // buffer catches whichever was evicted (3+1)
+    write(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&res));
+
+    clock_previous = getTime(sim);
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&res));
+    printf("Time: %d, Correct Time: 4 | Valor obtido: %d, Valor Correto: 7\n",
+           (int)(getTime(sim) - clock_previous), res);
+
+    clock_previous = getTime(sim);
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&res));
+    printf("Time: %d, Correct Time: 4\n", (int)(getTime(sim) - clock_previous));
+
+    const LevelStats *victim = getVictimStats(sim);
+    const LevelStats *dram = getLevelStats(sim, 1);
+    printf("VC | Hits: %llu, Misses: %llu | Correct: 2, 2\n",
+           (unsigned long long)victim->hits, (unsigned long long)victim->misses);
+    printf("DRAM | Writes: %llu, Correct Writes: 0\n", (unsigned long long)dram->writes);
+
+    destroySimulator(sim);
+}
+
+void test8() {
+    printf("-------- TEST 8 --------\n");
+
+    int clock_previous;
+    uint64_t value = 0x1122334455667788ull, res = 0;
+    unsigned char byte = 0;
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
+
+    // An unaligned 8-byte store straddles blocks 0 and 1: two misses
+    // (100+1 each), then two hits to load it back
+    clock_previous = getTime(sim);
+    writeBytes(sim, createAddress(0, 0, 60), (unsigned char *)(&value), sizeof(value));
+    printf("Store | Time: %d, Correct Time: 202\n", (int)(getTime(sim) - clock_previous));
+
+    clock_previous = getTime(sim);
+    readBytes(sim, createAddress(0, 0, 60), (unsigned char *)(&res), sizeof(res));
+    printf("Load | Time: %d, Correct Time: 2 | Valor obtido: %llx, Valor Correto: %llx\n",
+           (int)(getTime(sim) - clock_previous), (unsigned long long)res,
+           (unsigned long long)value);
+
+    // 4 blocks set, then copied 2 bytes into a block, i.e. over 5 blocks
+    setBytes(sim, createAddress(0, 4, 0), 0xab, 4 * BLOCK_SIZE);
+    copyBytes(sim, createAddress(0, 8, 2), createAddress(0, 4, 0), 4 * BLOCK_SIZE);
+    readBytes(sim, createAddress(0, 12, 1), &byte, 1);
+    printf("Copy | Valor obtido: %x, Valor Correto: ab\n", byte);
+    printf("L1 | Misses: %llu, Correct Misses: 11\n",
+           (unsigned long long)getLevelStats(sim, 0)->misses);
+
+    destroySimulator(sim);
+}
+
+void test9() {
+    printf("-------- TEST 9 --------\n");
+
+    const char *din = "/tmp/SimpleProgramTests.din";
+    const char *lackey = "/tmp/SimpleProgramTests.lackey";
+    const char *output = "/tmp/SimpleProgramTests.imported";
+    uint64_t count = 0;
+    Trace trace;
+
+    // Read, write, then an instruction fetch that is dropped
+    FILE *file = fopen(din, "w");
+    fprintf(file, "0 40\n1 44\n2 400\n");
+    fclose(file);
+    importTrace(din, IMPORT_AUTO, 0, output, 0, &count);
+    printf("Din | Records: %llu, Correct Records: 2\n", (unsigned long long)count);
+
+    // Valgrind's banner is skipped and a modify is a load then a store
+    file = fopen(lackey, "w");
+    fprintf(file, "==1== Lackey\nI  0400,4\n L 0100,8\n M 0104,4\n");
+    fclose(file);
+    importTrace(lackey, IMPORT_AUTO, 0, output, 0, &count);
+    if (openTrace(output, &trace) != 0) {
+      printf("Could not open trace\n");
+      return;
+    }
+    printf("Lackey | Records: %llu, Correct Records: 3\n", (unsigned long long)trace.count);
+    printf("Last | Address: %llx, Size: %u, Write: %d | Correct: 104, 4, 1\n",
+           (unsigned long long)trace.records[2].address, trace.records[2].size,
+           trace.records[2].mode == MODE_WRITE);
+
+    closeTrace(&trace);
+    remove(din);
+    remove(lackey);
+    remove(output);
+}
+
+void test10() {
+    printf("-------- TEST 10 --------\n");
+
+    static TraceRecord records[70000];
+    const char *path = "/tmp/SimpleProgramTests.packed";
+    Trace trace, index;
+    TraceCursor cursor;
+    const TraceRecord *piece;
+    uint64_t total = 0, n;
+    int same = 1;
+
+    // A loop over words, stores every fourth access: one byte per record
+    for (uint32_t i = 0; i < 70000; i++)
+      records[i] = (TraceRecord){i * WORD_SIZE, i % 4 ? MODE_READ : MODE_WRITE, WORD_SIZE, {0}};
+
+    writePackedTrace(path, records, 70000);
+    if (openTrace(path, &trace) != 0 || openTraceIndex(path, &index) != 0 ||
+        openTraceCursor(&trace, &cursor) != 0) {
+      printf("Could not open trace\n");
+      return;
+    }
+
+    // Nothing is decoded up front, the cursor reads one chunk at a time
+    while ((n = nextRecords(&cursor, UINT64_MAX, &piece)) > 0) {
+      same &= memcmp(piece, &records[total], n * sizeof(TraceRecord)) == 0;
+      total += n;
+    }
+    printf("Packed | Records: %llu, Read: %llu, Same: %d | Correct: 70000, 70000, 1\n",
+           (unsigned long long)trace.count, (unsigned long long)total, same);
+    closeTraceCursor(&cursor);
+
+    // Start from the middle: only the chunk of record 66000 is decoded
+    static TraceRecord chunk[TRACE_CHUNK_RECORDS];
+    uint64_t first = findChunk(&index, 66000);
+    int64_t count = decodeChunk(&index, first, chunk);
+    printf("Chunk: %llu of %llu, Records: %lld | Correct: 1 of 2, 4464\n",
+           (unsigned long long)first, (unsigned long long)index.numChunks, (long long)count);
+    printf("Address: %llu, Correct Address: 264000\n",
+           (unsigned long long)chunk[66000 - index.chunks[first].first].address);
+
+    closeTrace(&index);
+    closeTrace(&trace);
+    remove(path);
+}
+
 int main() {
   test0();
+  test3();
+  test4();
+  test5();
+  test6();
+  test7();
+  test8();
+  test9();
+  test10();
   
   return 0;
 }
\ No newline at end of file
@@ -6,23 +6,28 @@ int main() {
   srand(0);
 
   int clock1, value;
+  Simulator *sim = createSimulator(NULL);
+  if (sim == NULL) {
+    fprintf(stderr, "Not enough memory\n");
+    return 1;
+  }
 
   for(int n = 1; n <= DRAM_SIZE/4; n*=WORD_SIZE) {
 
-    resetTime();
-    initCache();
+    resetTime(sim);
+    initCache(sim);
 
     printf("\nNumber of words: %d\n", (n-1)/WORD_SIZE + 1);
     
     for(int i = 0; i < n; i+=WORD_SIZE) {
-      write(i, (unsigned char *)(&i));
-      clock1 = getTime();
+      write(sim, i, (unsigned char *)(&i));
+      clock1 = getTime(sim);
       printf("Write; Address %d; Value %d; Time %d\n", i, i, clock1);
     }
 
     for(int i = 0; i < n; i+=WORD_SIZE) {
-      read(i, (unsigned char *)(&value));
-      clock1 = getTime();
+      read(sim, i, (unsigned char *)(&value));
+      clock1 = getTime(sim);
       printf("Read; Address %d; Value %d; Time %d\n", i, value, clock1);
     }  
 
@@ -36,16 +41,17 @@ int main() {
     address = address - address % WORD_SIZE;
     int mode = rand() % 2;
     if (mode == MODE_READ) {
-      read(address, (unsigned char *)(&value));
-      clock1 = getTime();
+      read(sim, address, (unsigned char *)(&value));
+      clock1 = getTime(sim);
       printf("Read; Address %d; Value %d; Time %d\n", address, value, clock1);
     }
     else {
-      write(address, (unsigned char *)(&address));
-      clock1 = getTime();
+      write(sim, address, (unsigned char *)(&address));
+      clock1 = getTime(sim);
       printf("Write; Address %d; Value %d; Time %d\n", address, address, clock1);
     }
   }
   
+  destroySimulator(sim);
   return 0;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "L2Cache.h"
+#include "../Sampling.h"
 
 uint32_t createAddress(uint32_t tag, uint32_t index, uint32_t offset) {
   return ((tag << 15) | (index << 6) | offset);
@@ -12,31 +13,32 @@ void test0() {
   int clock1, clock2, diff;
   long int total;
 
-  resetTime();
-  initCache();
+  Simulator *sim = createSimulator(NULL);
+  resetTime(sim);
+  initCache(sim);
 
   value = 4;
   total = 0;
 
   // Apenas coloca o valor 4 na RAM para futuros acessos
   address = 0x00008000;
-  accessDRAM(address, &value, MODE_WRITE);
+  accessDRAM(sim, address, &value, MODE_WRITE);
   address = 0x00000000;
-  accessDRAM(address, &value, MODE_WRITE);
+  accessDRAM(sim, address, &value, MODE_WRITE);
 
 
   value = 8;
-  clock1 = getTime();
-  write(address, &value);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  write(sim, address, &value);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d\n", diff);
 
 
-  clock1 = getTime();
-  read(address, &res);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  read(sim, address, &res);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d | Valor obtido: %d, Valor Correto: 8\n", diff, res);
@@ -44,32 +46,33 @@ void test0() {
 
   value = 6;
   address = 0x00008000;
-  clock1 = getTime();
-  write(address, &value);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  write(sim, address, &value);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d\n", diff);
 
 
   address = 0x00000000;
-  clock1 = getTime();
-  read(address, &res);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  read(sim, address, &res);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d | Valor obtido: %d, Valor Correto: 8\n", diff, res);
 
 
   address = 0x00008000;
-  clock1 = getTime();
-  read(address, &res);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  read(sim, address, &res);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d | Valor obtido: %d, Valor Correto: 6\n", diff, res);
 
   printf("Tempo Total em Operações: %ld\n", total);
+  destroySimulator(sim);
 }
 
 void test2() {
@@ -77,26 +80,275 @@ void test2() {
     
     int clock_previous = 0, value;
   
-    resetTime();
-    initCache();
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
 
     // Read on (0, 0, 0) -> Load from DRAM (111)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (1, 0, 0) -> Load from DRAM (111)
-    read(createAddress(1, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 0, 0) -> Load from DRAM (111)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    destroySimulator(sim);
+}
+
+void test3() {
+    printf("-------- TEST 3 --------\n");
+
+    int value = 0;
+
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
+
+    // A and B share the L1 and the L2 set. The last read of A writes the
+    // dirty B back into an L2 that has just replaced it with A
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    write(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+
+    const LevelStats *l1 = getLevelStats(sim, 0);
+    const LevelStats *l2 = getLevelStats(sim, 1);
+    const LevelStats *dram = getLevelStats(sim, 2);
+
+    printf("L1 | Hits: %llu, Misses: %llu, Writebacks: %llu | Correct: 1, 3, 1\n",
+           (unsigned long long)l1->hits, (unsigned long long)l1->misses,
+           (unsigned long long)l1->writebacks);
+    printf("L2 | Hits: %llu, Misses: %llu, Evictions: %llu | Correct: 0, 4, 3\n",
+           (unsigned long long)l2->hits, (unsigned long long)l2->misses,
+           (unsigned long long)l2->evictions);
+    printf("DRAM | Bytes read: %llu, Correct Bytes read: %d\n",
+           (unsigned long long)dram->bytesRead, 4 * BLOCK_SIZE);
+
+    destroySimulator(sim);
+}
+
+void test4() {
+    printf("-------- TEST 4 --------\n");
+
+    int clock_previous, value = 0;
+    CacheConfig config;
+    modelConfig(&config);
+    config.levels[0].prefetcher = PREFETCH_NEXT_LINE;
+
+    Simulator *sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+
+    // The miss on block 0 prefetches block 1 in the background (110)
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    for (int i = 0; i < 200; i++)
+      read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+
+    // Block 1 has arrived and prefetches block 2, which is still on its way
+    // when it is read right after
+    clock_previous = getTime(sim);
+    read(sim, createAddress(0, 1, 0), (unsigned char *)(&value));
+    printf("Timely | Time: %d, Correct Time: 1\n", (int)(getTime(sim) - clock_previous));
+
+    clock_previous = getTime(sim);
+    read(sim, createAddress(0, 2, 0), (unsigned char *)(&value));
+    printf("Late | Time: %d, Correct Time: 111\n", (int)(getTime(sim) - clock_previous));
+
+    const LevelStats *l1 = getLevelStats(sim, 0);
+    printf("L1 | Prefetches: %llu, Useful: %llu, Late: %llu | Correct: 3, 2, 1\n",
+           (unsigned long long)l1->prefetches, (unsigned long long)l1->usefulPrefetches,
+           (unsigned long long)l1->latePrefetches);
+
+    destroySimulator(sim);
+}
+
+void test5() {
+    printf("-------- TEST 5 --------\n");
+
+    int clock_previous, value = 3, res = 0;
+    CacheConfig config;
+    modelConfig(&config);
+    config.levels[0].writeAllocate = 0;
+    config.writeBufferEntries = 4;
+
+    Simulator *sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+
+    // Store misses go around the L1 into the write buffer (1 each). Block 0
+    // starts draining right away, the stores to block 1 wait and merge
+    clock_previous = getTime(sim);
+    write(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    write(sim, createAddress(0, 1, 0), (unsigned char *)(&value));
+    write(sim, createAddress(0, 1, 4), (unsigned char *)(&value));
+    printf("Stores | Time: %d, Correct Time: 3\n", (int)(getTime(sim) - clock_previous));
+
+    // The load waits for both blocks to reach the L2 (105 from time 1, then
+    // 105 more) before reading its block from it (10+1)
+    clock_previous = getTime(sim);
+    read(sim, createAddress(0, 1, 4), (unsigned char *)(&res));
+    printf("Load | Time: %d, Correct Time: 219 | Valor obtido: %d, Valor Correto: 3\n",
+           (int)(getTime(sim) - clock_previous), res);
+
+    const LevelStats *buffer = getWriteBufferStats(sim);
+    printf("WB | Merged: %llu, Entries: %llu | Correct: 1, 2\n",
+           (unsigned long long)buffer->hits, (unsigned long long)buffer->misses);
+
+    destroySimulator(sim);
+}
+
+void test6() {
+    printf("-------- TEST 6 --------\n");
+
+    int value = 7, res = 0;
+    CacheConfig config;
+    modelConfig(&config);
+    config.levels[0].ways = 2;
+    config.levels[1].inclusion = INCLUSION_INCLUSIVE;
+
+    Simulator *sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+
+    // Both blocks fit in the L1 set but not in the L2 one: each takes the
+    // other one out of the L1 too, the dirty one moving its data down
+    write(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&res));
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&res));
+    printf("Inclusive | Valor obtido: %d, Valor Correto: 7\n", res);
+
+    const LevelStats *l1 = getLevelStats(sim, 0), *dram = getLevelStats(sim, 2);
+    printf("L1 | Misses: %llu, Invalidations: %llu | Correct: 3, 2\n",
+           (unsigned long long)l1->misses, (unsigned long long)l1->invalidations);
+    printf("DRAM | Writes: %llu, Correct Writes: 1\n", (unsigned long long)dram->writes);
+    destroySimulator(sim);
+
+    // The other way around the L2 only gets the blocks the L1 evicts, and
+    // gives them back
+    config.levels[0].ways = 1;
+    config.levels[1].inclusion = INCLUSION_EXCLUSIVE;
+    sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+
+    value = 5;
+    write(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    read(sim, createAddress(0, 256, 0), (unsigned char *)(&res));
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&res));
+    printf("Exclusive | Valor obtido: %d, Valor Correto: 5\n", res);
+
+    const LevelStats *l2 = getLevelStats(sim, 1);
+    dram = getLevelStats(sim, 2);
+    printf("L2 | Hits: %llu, Misses: %llu | Correct: 1, 2\n",
+           (unsigned long long)l2->hits, (unsigned long long)l2->misses);
+    printf("DRAM | Reads: %llu, Writes: %llu | Correct: 2, 0\n",
+           (unsigned long long)dram->reads, (unsigned long long)dram->writes);
+
+    destroySimulator(sim);
+}
+
+void test7() {
+    printf("-------- TEST 7 --------\n");
+
+    static TraceRecord records[4000];
+    Trace trace = {records, 4000, NULL, 0, NULL, NULL, 0};
+    TraceCursor cursor;
+    SampleConfig sample = {1000, 100, 100};
+    SampleResult result;
+    CacheConfig config;
+    modelConfig(&config);
+    config.tagOnly = 1;
+
+    // Eight blocks read over and over: once warm, every window only hits
+    for (uint32_t i = 0; i < 4000; i++)
+      records[i] = (TraceRecord){createAddress(0, i % 8, 0), MODE_READ, WORD_SIZE, {0}};
+
+    Simulator *sim = createSimulator(&config);
+    openTraceCursor(&trace, &cursor);
+    sampleTrace(sim, &cursor, &sample, &result);
+    printf("Windows: %llu, Correct Windows: 4\n", (unsigned long long)result.windows);
+    printf("Loop | Cycles: %.0f +- %.0f | Correct: 4000 +- 0\n", result.cycles.mean,
+           result.cycles.error);
+    printf("L1 | Miss rate: %.2f, Correct Miss rate: 0.00\n", result.missRate[0].mean);
+    destroySimulator(sim);
+
+    // A stream of new blocks: every access misses down to DRAM (100+10+1)
+    for (uint32_t i = 0; i < 4000; i++)
+      records[i].address = createAddress(i / 512, i % 512, 0);
+
+    sim = createSimulator(&config);
+    openTraceCursor(&trace, &cursor);
+    sampleTrace(sim, &cursor, &sample, &result);
+    printf("Stream | Cycles: %.0f +- %.0f | Correct: 444000 +- 0\n", result.cycles.mean,
+           result.cycles.error);
+    printf("L2 | Miss rate: %.2f, Correct Miss rate: 1.00\n", result.missRate[1].mean);
+    destroySimulator(sim);
+
+    // Warming an inclusive L2 still drops the L1 copies, but counts nothing
+    config.levels[0].ways = 2;
+    config.levels[1].inclusion = INCLUSION_INCLUSIVE;
+    records[0].address = createAddress(0, 0, 0);
+    records[1].address = createAddress(1, 0, 0);
+    records[2].address = createAddress(0, 0, 0);
+    sim = createSimulator(&config);
+    warmTrace(sim, records, 3);
+    printf("Warm | L1 Invalidations: %llu, Correct: 0\n",
+           (unsigned long long)getLevelStats(sim, 0)->invalidations);
+    destroySimulator(sim);
+}
+
+void test8() {
+    printf("-------- TEST 8 --------\n");
+
+    int clock_previous, value = 9;
+    CacheConfig config;
+    modelConfig(&config);
+    config.tagOnly = 1;
+    config.levels[0].writeThrough = 1;
+    config.levels[1].writeThrough = 1;
+
+    // Tag-only stores that go through both levels only take DRAM's time:
+    // the miss fetches the block (100+10), then the store goes down (1+5+50)
+    Simulator *sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+    clock_previous = getTime(sim);
+    write(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Write-through | Time: %d, Correct Time: 166\n", (int)(getTime(sim) - clock_previous));
+    printf("DRAM | Writes: %llu, Correct Writes: 1\n",
+           (unsigned long long)getLevelStats(sim, 2)->writes);
+    destroySimulator(sim);
+
+    // Store misses that go around both levels straight to DRAM (1+5+50)
+    config.levels[0].writeThrough = 0;
+    config.levels[1].writeThrough = 0;
+    config.levels[0].writeAllocate = 0;
+    config.levels[1].writeAllocate = 0;
+    sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+    clock_previous = getTime(sim);
+    write(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("No-write-allocate | Time: %d, Correct Time: 56\n",
+           (int)(getTime(sim) - clock_previous));
+    printf("DRAM | Writes: %llu, Correct Writes: 1\n",
+           (unsigned long long)getLevelStats(sim, 2)->writes);
+    destroySimulator(sim);
 }
 
 int main() {
   test0();
+  test3();
+  test4();
+  test5();
+  test6();
+  test7();
+  test8();
   
   return 0;
 }
\ No newline at end of file
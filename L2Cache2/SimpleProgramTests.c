@@ -13,31 +13,32 @@ void test0() {
   int clock1, clock2, diff;
   long int total;
 
-  resetTime();
-  initCache();
+  Simulator *sim = createSimulator(NULL);
+  resetTime(sim);
+  initCache(sim);
 
   value = 4;
   total = 0;
 
   // Apenas coloca o valor 4 na RAM para futuros acessos
   address = 0x00008000;
-  accessDRAM(address, &value, MODE_WRITE);
+  accessDRAM(sim, address, &value, MODE_WRITE);
   address = 0x00000000;
-  accessDRAM(address, &value, MODE_WRITE);
+  accessDRAM(sim, address, &value, MODE_WRITE);
 
 
   value = 8;
-  clock1 = getTime();
-  write(address, &value);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  write(sim, address, &value);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d\n", diff);
 
 
-  clock1 = getTime();
-  read(address, &res);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  read(sim, address, &res);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d | Valor obtido: %d, Valor Correto: 8\n", diff, res);
@@ -45,32 +46,33 @@ void test0() {
 
   value = 6;
   address = 0x00008000;
-  clock1 = getTime();
-  write(address, &value);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  write(sim, address, &value);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d\n", diff);
 
 
   address = 0x00000000;
-  clock1 = getTime();
-  read(address, &res);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  read(sim, address, &res);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d | Valor obtido: %d, Valor Correto: 8\n", diff, res);
 
 
   address = 0x00008000;
-  clock1 = getTime();
-  read(address, &res);
-  clock2 = getTime();
+  clock1 = getTime(sim);
+  read(sim, address, &res);
+  clock2 = getTime(sim);
   diff = clock2 - clock1;
   total += diff;
   printf("Tempo: %d | Valor obtido: %d, Valor Correto: 6\n", diff, res);
 
   printf("Tempo Total em Operações: %ld\n", total);
+  destroySimulator(sim);
 }
 
 
@@ -79,58 +81,60 @@ void test1() {
     
     int clock_previous = 0, value;
   
-    resetTime();
-    initCache();
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
 
     // Read on (0, 0, 0) -> Load from DRAM (100+10+1)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 0, 1) -> Load from L1 (1)
-    read(createAddress(0, 0, 1), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 1), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 1, 4) -> Load from DRAM (100+10+1)
-    read(createAddress(0, 1, 4), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 1, 4), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (1, 0, 0) -> Load from DRAM (100+10+1)
-    read(createAddress(1, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (1, 0, 1) -> Load from L1 (1)
-    read(createAddress(1, 0, 1), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(1, 0, 1), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 0, 0) -> Load from L2 (10+1)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (2, 0, 0) -> Load from DRAM (111)
-    read(createAddress(2, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(2, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (1, 0, 0) -> Load from L2 (11)
-    read(createAddress(1, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (3, 0, 0) -> Load from DRAM (111)
-    read(createAddress(3, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(3, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 0, 0) -> Load from DRAM (111)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
+    destroySimulator(sim);
 }
 
 void test2() {
@@ -138,33 +142,327 @@ void test2() {
     
     int clock_previous = 0, value;
   
-    resetTime();
-    initCache();
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
 
     // Read on (0, 0, 0) -> Load from DRAM (111)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (1, 0, 0) -> Load from DRAM (111)
-    read(createAddress(1, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (2, 0, 0) -> Load from DRAM (111)
-    read(createAddress(2, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(2, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
 
     // Read on (0, 0, 0) -> Load from L2 (11)
-    read(createAddress(0, 0, 0), (unsigned char *)(&value));
-    printf("Time: %d\n", (getTime() - clock_previous));
-    clock_previous = getTime();
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d\n", (int)(getTime(sim) - clock_previous));
+    clock_previous = getTime(sim);
+    destroySimulator(sim);
 }
 
 
+void test3() {
+    printf("-------- TEST 3 --------\n");
+
+    int clock_previous, value;
+    CacheConfig config;
+
+    // Same hierarchy with a 4-way L2 chosen at runtime
+    modelConfig(&config);
+    parseConfigOption(&config, "l2_ways", "4");
+
+    Simulator *sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+
+    // Tags 0..3 all map to L1 index 0 and to the same L2 set
+    for (int tag = 0; tag < 4; tag++)
+      read(sim, createAddress(tag, 0, 0), (unsigned char *)(&value));
+
+    // Read on (0, 0, 0) -> Load from L2 (11), the 4 blocks fit in one set
+    clock_previous = getTime(sim);
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d, Correct Time: 11\n", (int)(getTime(sim) - clock_previous));
+
+    destroySimulator(sim);
+}
+
+
+void test4() {
+    printf("-------- TEST 4 --------\n");
+
+    int clock_previous, value;
+    CacheConfig config;
+
+    // Fully associative L2: a single set holding every block
+    modelConfig(&config);
+    config.levels[1].ways = config.levels[1].size / config.blockSize;
+
+    Simulator *sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+
+    for (int tag = 0; tag < 4; tag++)
+      read(sim, createAddress(tag, 0, 0), (unsigned char *)(&value));
+
+    // Read on (0, 0, 0) -> Load from L2 (11), no conflict misses in L2
+    clock_previous = getTime(sim);
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    printf("Time: %d, Correct Time: 11\n", (int)(getTime(sim) - clock_previous));
+
+    destroySimulator(sim);
+}
+
+
+void test5() {
+    printf("-------- TEST 5 --------\n");
+
+    const char *policies[2] = {"lru", "fifo"};
+    const int expected[2] = {11, 111};
+    int clock_previous, value;
+
+    for (int p = 0; p < 2; p++) {
+      CacheConfig config;
+      modelConfig(&config);
+      parseConfigOption(&config, "l2_policy", policies[p]);
+
+      Simulator *sim = createSimulator(&config);
+      resetTime(sim);
+      initCache(sim);
+
+      // Tags 0, 1, 0, 2 on the same 2-way L2 set: the re-use of tag 0 keeps
+      // it under LRU, FIFO evicts it anyway because it was filled first
+      read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+      read(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+      read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+      read(sim, createAddress(2, 0, 0), (unsigned char *)(&value));
+
+      clock_previous = getTime(sim);
+      read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+      printf("Policy: %s | Time: %d, Correct Time: %d\n", policies[p],
+             (int)(getTime(sim) - clock_previous), expected[p]);
+
+      destroySimulator(sim);
+    }
+}
+
+
+void test6() {
+    printf("-------- TEST 6 --------\n");
+
+    int time[2], value = 0;
+
+    // The same sequence with and without data: tag-only mode must keep the
+    // timing, including the write backs of the dirty blocks it evicts
+    for (int tagOnly = 0; tagOnly < 2; tagOnly++) {
+      CacheConfig config;
+      modelConfig(&config);
+      config.tagOnly = tagOnly;
+
+      Simulator *sim = createSimulator(&config);
+      resetTime(sim);
+      initCache(sim);
+
+      write(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+      read(sim, createAddress(1, 0, 0), (unsigned char *)(&value));
+      write(sim, createAddress(2, 0, 4), (unsigned char *)(&value));
+      read(sim, createAddress(3, 0, 0), (unsigned char *)(&value));
+      read(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+
+      time[tagOnly] = getTime(sim);
+      destroySimulator(sim);
+    }
+    printf("Tag only | Time: %d, Correct Time: %d\n", time[1], time[0]);
+}
+
+void test7() {
+    printf("-------- TEST 7 --------\n");
+
+    int value = 42, res = 0;
+    uint64_t far = (uint64_t)5 << 40;   // far beyond any dense DRAM
+
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
+
+    // Written at 5 TiB, evicted by a conflicting write and read back
+    write(sim, far, (unsigned char *)(&value));
+    write(sim, far + L2_SIZE, (unsigned char *)(&value));
+    write(sim, far + 2 * L2_SIZE, (unsigned char *)(&value));
+    read(sim, far, (unsigned char *)(&res));
+
+    printf("Valor obtido: %d, Valor Correto: 42\n", res);
+
+    destroySimulator(sim);
+}
+
+void test8() {
+    printf("-------- TEST 8 --------\n");
+
+    int value = 7, res = 0;
+    CacheConfig config;
+    modelConfig(&config);
+    config.cores = 2;
+
+    Simulator *sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+
+    // Core 1 reads the block core 0 modified, then takes it over: core 0
+    // must see the new value, served by core 1
+    write(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    setCore(sim, 1);
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&res));
+    printf("Core 1 | Valor obtido: %d, Valor Correto: 7\n", res);
+
+    value = 9;
+    write(sim, createAddress(0, 0, 0), (unsigned char *)(&value));
+    setCore(sim, 0);
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&res));
+    printf("Core 0 | Valor obtido: %d, Valor Correto: 9\n", res);
+
+    const LevelStats *core0 = getCoreStats(sim, 0), *core1 = getCoreStats(sim, 1);
+    printf("Transfers: %llu, Correct Transfers: 2\n",
+           (unsigned long long)(core0->transfers + core1->transfers));
+    printf("Upgrades: %llu, Correct Upgrades: 1\n", (unsigned long long)core1->upgrades);
+    printf("Invalidations: %llu, Correct Invalidations: 1\n",
+           (unsigned long long)core0->invalidations);
+
+    destroySimulator(sim);
+}
+
+void test9() {
+    printf("-------- TEST 9 --------\n");
+
+    int res = 0;
+    uint64_t request;
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
+
+    // Two misses to different blocks overlap: both are done after one miss
+    issueRequest(sim, createAddress(0, 0, 0), (unsigned char *)(&res), MODE_READ, &request);
+    issueRequest(sim, createAddress(1, 0, 0), (unsigned char *)(&res), MODE_READ, &request);
+    printf("In flight: %u, Correct In flight: 2\n", requestsInFlight(sim));
+    completeRequest(sim, &request);
+    completeRequest(sim, &request);
+    printf("Request: %llu, Correct Request: 1\n", (unsigned long long)request);
+    printf("Time: %llu, Correct Time: 111\n", (unsigned long long)getTime(sim));
+
+    // A second read of a block still on its way waits for the first one
+    issueRequest(sim, createAddress(2, 0, 0), (unsigned char *)(&res), MODE_READ, &request);
+    issueRequest(sim, createAddress(2, 0, 4), (unsigned char *)(&res), MODE_READ, &request);
+    completeRequest(sim, &request);
+    completeRequest(sim, &request);
+    printf("Time: %llu, Correct Time: 222\n", (unsigned long long)getTime(sim));
+    printf("Merges: %llu, Correct Merges: 1\n",
+           (unsigned long long)getLevelStats(sim, 0)->merges);
+
+    destroySimulator(sim);
+}
+
+void test10() {
+    printf("-------- TEST 10 --------\n");
+
+    int clock_previous, res = 0;
+    CacheConfig config;
+    modelConfig(&config);
+    config.levels[2].size = 4096 * config.blockSize;
+
+    Simulator *sim = createSimulator(&config);
+    resetTime(sim);
+    initCache(sim);
+
+    // A cold miss goes through the three levels down to DRAM (100+30+10+1)
+    clock_previous = getTime(sim);
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&res));
+    printf("Miss | Time: %d, Correct Time: 141\n", (int)(getTime(sim) - clock_previous));
+
+    // Three blocks of one L2 set: the first one is only left in the L3
+    read(sim, createAddress(1, 0, 0), (unsigned char *)(&res));
+    read(sim, createAddress(2, 0, 0), (unsigned char *)(&res));
+    clock_previous = getTime(sim);
+    read(sim, createAddress(0, 0, 0), (unsigned char *)(&res));
+    printf("L3 hit | Time: %d, Correct Time: 41\n", (int)(getTime(sim) - clock_previous));
+
+    const LevelStats *l3 = getLevelStats(sim, 2);
+    printf("L3 | Hits: %llu, Misses: %llu | Correct: 1, 3\n",
+           (unsigned long long)l3->hits, (unsigned long long)l3->misses);
+    printf("Levels: %u, Correct Levels: 3\n", getNumLevels(sim));
+
+    destroySimulator(sim);
+}
+
+void test11() {
+    printf("-------- TEST 11 --------\n");
+
+    int value = 42, res = 0, restored = 0;
+    const char *path = "/tmp/L2_2Cache_test11.ckpt";
+
+    Simulator *sim = createSimulator(NULL);
+    resetTime(sim);
+    initCache(sim);
+
+    // Warm up, leaving a dirty block in the L1, then save everything
+    write(sim, createAddress(5, 0, 0), (unsigned char *)(&value));
+    read(sim, createAddress(6, 1, 0), (unsigned char *)(&res));
+    printf("Saved: %d, Correct Saved: 0\n", saveCheckpoint(sim, path));
+
+    Simulator *copy = loadCheckpoint(path);
+    if (copy == NULL) {
+      printf("Could not restore the checkpoint\n");
+      destroySimulator(sim);
+      return;
+    }
+    printf("Time: %llu, Correct Time: %llu\n", (unsigned long long)getTime(copy),
+           (unsigned long long)getTime(sim));
+
+    // The restored simulator carries on warm, exactly like the original
+    read(sim, createAddress(5, 0, 0), (unsigned char *)(&res));
+    read(copy, createAddress(5, 0, 0), (unsigned char *)(&restored));
+    printf("Valor obtido: %d, Valor Correto: %d\n", restored, res);
+    printf("Time: %llu, Correct Time: %llu\n", (unsigned long long)getTime(copy),
+           (unsigned long long)getTime(sim));
+
+    const LevelStats *l1 = getLevelStats(copy, 0);
+    printf("L1 | Hits: %llu, Misses: %llu | Correct: 1, 2\n",
+           (unsigned long long)l1->hits, (unsigned long long)l1->misses);
+    destroySimulator(copy);
+
+    // A checkpoint with anything after the saved state is rejected
+    FILE *file = fopen(path, "ab");
+    if (file != NULL) {
+      fputc(0, file);
+      fclose(file);
+    }
+    copy = loadCheckpoint(path);
+    printf("Trailing bytes | Restored: %d, Correct Restored: 0\n", copy != NULL);
+    if (copy != NULL)
+      destroySimulator(copy);
+
+    destroySimulator(sim);
+    remove(path);
+}
+
 int main() {
   test0();
+  test3();
+  test4();
+  test5();
+  test6();
+  test7();
+  test8();
+  test9();
+  test10();
+  test11();
   
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Memory.h"
+
+#define EMPTY_PAGE UINT64_MAX  // page numbers have at most 64 - DRAM_PAGE_SHIFT bits
+#define INITIAL_SLOTS 64
+
+static uint64_t hashPage(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xFF51AFD7ED558CCDull;
+  return key ^ (key >> 33);
+}
+
+/**
+ * Function used to set up an empty memory.
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int initMemory(Memory *memory) {
+  memory->slots = INITIAL_SLOTS;
+  memory->count = 0;
+  memory->lastKey = EMPTY_PAGE;
+  memory->lastPage = NULL;
+  memory->keys = malloc(INITIAL_SLOTS * sizeof(uint64_t));
+  memory->pages = calloc(INITIAL_SLOTS, sizeof(uint8_t *));
+
+  if (memory->keys == NULL || memory->pages == NULL) {
+    freeMemory(memory);
+    return -1;
+  }
+  memset(memory->keys, 0xFF, INITIAL_SLOTS * sizeof(uint64_t));
+  return 0;
+}
+
+/**
+ * Function used to release every page of a memory.
+ */
+void freeMemory(Memory *memory) {
+  for (uint64_t i = 0; memory->pages != NULL && i < memory->slots; i++)
+    free(memory->pages[i]);
+  free(memory->keys);
+  free(memory->pages);
+  memory->keys = NULL;
+  memory->pages = NULL;
+  memory->count = 0;
+  memory->lastPage = NULL;
+}
+
+/**
+ * Function used to get the page holding address, or NULL if it was never
+ * written.
+ */
+uint8_t *findPage(Memory *memory, uint64_t address) {
+  uint64_t key = address >> DRAM_PAGE_SHIFT;
+  uint64_t mask = memory->slots - 1;
+
+  if (key == memory->lastKey)
+    return memory->lastPage;
+
+  for (uint64_t i = hashPage(key) & mask; memory->keys[i] != EMPTY_PAGE; i = (i + 1) & mask) {
+    if (memory->keys[i] == key) {
+      memory->lastKey = key;
+      memory->lastPage = memory->pages[i];
+      return memory->pages[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Function used to double the hash table once it is half full.
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+static int growMemory(Memory *memory) {
+  uint64_t slots = memory->slots * 2;
+  uint64_t *keys = malloc(slots * sizeof(uint64_t));
+  uint8_t **pages = calloc(slots, sizeof(uint8_t *));
+
+  if (keys == NULL || pages == NULL) {
+    free(keys);
+    free(pages);
+    return -1;
+  }
+  memset(keys, 0xFF, slots * sizeof(uint64_t));
+
+  for (uint64_t j = 0; j < memory->slots; j++) {
+    if (memory->keys[j] == EMPTY_PAGE)
+      continue;
+    uint64_t i = hashPage(memory->keys[j]) & (slots - 1);
+    while (keys[i] != EMPTY_PAGE)
+      i = (i + 1) & (slots - 1);
+    keys[i] = memory->keys[j];
+    pages[i] = memory->pages[j];
+  }
+
+  free(memory->keys);
+  free(memory->pages);
+  memory->keys = keys;
+  memory->pages = pages;
+  memory->slots = slots;
+  return 0;
+}
+
+/**
+ * Function used to get the page holding address, allocating a zeroed one
+ * on first use. Returns NULL if there is not enough memory.
+ */
+static uint8_t *touchPage(Memory *memory, uint64_t address) {
+  uint8_t *page = findPage(memory, address);
+  if (page != NULL)
+    return page;
+
+  if ((memory->count + 1) * 2 > memory->slots && growMemory(memory) != 0)
+    return NULL;
+
+  page = calloc(DRAM_PAGE_SIZE, 1);
+  if (page == NULL)
+    return NULL;
+
+  uint64_t key = address >> DRAM_PAGE_SHIFT;
+  uint64_t mask = memory->slots - 1;
+  uint64_t i = hashPage(key) & mask;
+  while (memory->keys[i] != EMPTY_PAGE)
+    i = (i + 1) & mask;
+
+  memory->keys[i] = key;
+  memory->pages[i] = page;
+  memory->count++;
+  memory->lastKey = key;
+  memory->lastPage = page;
+  return page;
+}
+
+/**
+ * Function used to read size bytes that don't cross a page boundary.
+ */
+void readMemory(Memory *memory, uint64_t address, uint8_t *data, uint32_t size) {
+  uint8_t *page = findPage(memory, address);
+
+  if (page != NULL)
+    memcpy(data, &page[address & (DRAM_PAGE_SIZE - 1)], size);
+  else
+    memset(data, 0, size);
+}
+
+/**
+ * Function used to write size bytes that don't cross a page boundary.
+ * Returns 0 on success and -1 if the page can't be allocated.
+ */
+int writeMemory(Memory *memory, uint64_t address, const uint8_t *data, uint32_t size) {
+  uint8_t *page = touchPage(memory, address);
+
+  if (page == NULL)
+    return -1;
+  memcpy(&page[address & (DRAM_PAGE_SIZE - 1)], data, size);
+  return 0;
+}
+
+/**
+ * Function used to append every page of a memory to a checkpoint, each
+ * one after its page number.
+ * Returns 0 on success and -1 on a write error.
+ */
+int saveMemory(const Memory *memory, FILE *file) {
+  if (saveBytes(file, &memory->count, sizeof(memory->count)) != 0)
+    return -1;
+
+  for (uint64_t i = 0; i < memory->slots; i++) {
+    if (memory->keys[i] == EMPTY_PAGE)
+      continue;
+    if (saveBytes(file, &memory->keys[i], sizeof(uint64_t)) != 0 ||
+        saveBytes(file, memory->pages[i], DRAM_PAGE_SIZE) != 0)
+      return -1;
+  }
+  return 0;
+}
+
+/**
+ * Function used to add the pages saved by saveMemory() to an empty memory.
+ * Returns 0 on success and -1 if the checkpoint is too short or there is
+ * not enough memory.
+ */
+int loadMemory(Memory *memory, Snapshot *snapshot) {
+  uint64_t Count, Key;
+
+  if (loadBytes(snapshot, &Count, sizeof(Count)) != 0)
+    return -1;
+
+  while (Count-- > 0) {
+    if (loadBytes(snapshot, &Key, sizeof(Key)) != 0 ||
+        (size_t)(snapshot->end - snapshot->next) < DRAM_PAGE_SIZE ||
+        writeMemory(memory, Key << DRAM_PAGE_SHIFT, snapshot->next, DRAM_PAGE_SIZE) != 0)
+      return -1;
+    snapshot->next += DRAM_PAGE_SIZE;
+  }
+  return 0;
+}
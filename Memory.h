@@ -0,0 +1,37 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdint.h>
+#include "Checkpoint.h"
+
+#define DRAM_PAGE_SHIFT 16  // 64 KiB pages
+#define DRAM_PAGE_SIZE (1u << DRAM_PAGE_SHIFT)  // a multiple of MAX_BLOCK_SIZE
+
+/*
+ * Sparse byte addressable memory over the whole 64-bit address space.
+ * Pages are allocated on their first write and found through a hash table
+ * of page numbers, so memory use follows the touched footprint. Untouched
+ * pages read as zeros.
+ */
+typedef struct Memory {
+  uint64_t *keys;     // page numbers, EMPTY_PAGE for free slots
+  uint8_t **pages;
+  uint64_t slots;     // power of two
+  uint64_t count;
+  uint64_t lastKey;   // last page found, most accesses hit it again
+  uint8_t *lastPage;
+} Memory;
+
+/*********************** Memory *************************/
+
+int initMemory(Memory *memory);
+void freeMemory(Memory *memory);
+
+uint8_t *findPage(Memory *memory, uint64_t address);
+void readMemory(Memory *memory, uint64_t address, uint8_t *data, uint32_t size);
+int writeMemory(Memory *memory, uint64_t address, const uint8_t *data, uint32_t size);
+
+int saveMemory(const Memory *memory, FILE *file);
+int loadMemory(Memory *memory, Snapshot *snapshot);
+
+#endif
@@ -0,0 +1,202 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Prefetch.h"
+
+/**
+ * Function used to fill candidates with the degree blocks that follow
+ * block by stride, starting distance strides ahead.
+ */
+static uint32_t aheadOf(Prefetcher *prefetcher, uint64_t block, int64_t stride,
+                        uint64_t *candidates) {
+  for (uint32_t i = 0; i < prefetcher->degree; i++)
+    candidates[i] = block + (uint64_t)(stride * (int64_t)(prefetcher->distance + i));
+  return prefetcher->degree;
+}
+
+static void clearTable(Prefetcher *prefetcher) {
+  if (prefetcher->table != NULL)
+    memset(prefetcher->table, 0, prefetcher->entries * sizeof(PrefetchEntry));
+  prefetcher->clock = 0;
+}
+
+/***************** None ****************/
+
+static uint32_t noneTrain(Prefetcher *prefetcher, uint64_t block, uint64_t *candidates) {
+  (void)prefetcher;
+  (void)block;
+  (void)candidates;
+  return 0;
+}
+
+/***************** Next line ****************/
+
+static uint32_t nextLineTrain(Prefetcher *prefetcher, uint64_t block, uint64_t *candidates) {
+  return aheadOf(prefetcher, block, 1, candidates);
+}
+
+/***************** Stride ****************/
+/*
+ * Without a PC the accesses are told apart by region: each entry follows
+ * the last block and stride seen in one region, and prefetches once the
+ * same stride comes back STRIDE_CONFIDENCE times in a row.
+ */
+static uint32_t strideTrain(Prefetcher *prefetcher, uint64_t block, uint64_t *candidates) {
+  uint64_t Region = block >> STRIDE_REGION_SHIFT;
+  PrefetchEntry *Entry = &prefetcher->table[Region % prefetcher->entries];
+  int64_t Stride = (int64_t)(block - Entry->last);
+
+  if (Entry->tag != Region + 1) {    // tag 0 marks free entries
+    Entry->tag = Region + 1;
+    Entry->last = block;
+    Entry->stride = 0;
+    Entry->confidence = 0;
+    return 0;
+  }
+
+  if (Stride == 0)
+    return 0;
+
+  if (Stride == Entry->stride) {
+    if (Entry->confidence < STRIDE_CONFIDENCE)
+      Entry->confidence++;
+  }
+  else {
+    Entry->stride = Stride;
+    Entry->confidence = 0;
+  }
+  Entry->last = block;
+
+  if (Entry->confidence < STRIDE_CONFIDENCE)
+    return 0;
+  return aheadOf(prefetcher, block, Stride, candidates);
+}
+
+/***************** Stream buffers ****************/
+/*
+ * Each buffer follows one stream of blocks. A trigger within STREAM_WINDOW
+ * blocks past the head of a buffer, in its direction, moves the head there
+ * and fetches ahead of it. A first trigger next to a fresh buffer sets its
+ * direction. Other triggers take over the least recently used buffer.
+ */
+static uint32_t streamTrain(Prefetcher *prefetcher, uint64_t block, uint64_t *candidates) {
+  PrefetchEntry *Oldest = &prefetcher->table[0];
+
+  prefetcher->clock++;
+  for (uint32_t i = 0; i < prefetcher->entries; i++) {
+    PrefetchEntry *Buffer = &prefetcher->table[i];
+    int64_t Delta = (int64_t)(block - Buffer->last);
+
+    if (Buffer->used < Oldest->used)
+      Oldest = Buffer;
+    if (Buffer->tag == 0)
+      continue;
+
+    if (Buffer->stride == 0 && Delta != 0 && Delta >= -STREAM_WINDOW && Delta <= STREAM_WINDOW)
+      Buffer->stride = Delta > 0 ? 1 : -1;
+    else if (Buffer->stride == 0 || Delta * Buffer->stride <= 0 ||
+             Delta * Buffer->stride > STREAM_WINDOW)
+      continue;
+
+    Buffer->last = block;
+    Buffer->used = prefetcher->clock;
+    return aheadOf(prefetcher, block, Buffer->stride, candidates);
+  }
+
+  Oldest->tag = 1;
+  Oldest->last = block;
+  Oldest->stride = 0;
+  Oldest->used = prefetcher->clock;
+  return 0;
+}
+
+static const PrefetcherOps Prefetchers[NUM_PREFETCHERS] = {
+  {"none", clearTable, noneTrain},
+  {"next_line", clearTable, nextLineTrain},
+  {"stride", clearTable, strideTrain},
+  {"stream", clearTable, streamTrain},
+};
+
+/**
+ * Function used to set up a PREFETCH_* prefetcher fetching degree blocks
+ * per trigger, the first one distance blocks ahead.
+ * Returns 0 on success and -1 for bad parameters or not enough memory.
+ */
+int initPrefetcher(Prefetcher *prefetcher, uint32_t type, uint32_t degree,
+                   uint32_t distance) {
+  if (type >= NUM_PREFETCHERS || degree == 0 || degree > MAX_PREFETCH_DEGREE || distance == 0)
+    return -1;
+
+  prefetcher->ops = &Prefetchers[type];
+  prefetcher->type = type;
+  prefetcher->degree = degree;
+  prefetcher->distance = distance;
+  prefetcher->entries = type == PREFETCH_STRIDE ? STRIDE_ENTRIES :
+                        type == PREFETCH_STREAM ? STREAM_BUFFERS : 0;
+  prefetcher->table = NULL;
+
+  if (prefetcher->entries != 0) {
+    prefetcher->table = calloc(prefetcher->entries, sizeof(PrefetchEntry));
+    if (prefetcher->table == NULL)
+      return -1;
+  }
+
+  resetPrefetcher(prefetcher);
+  return 0;
+}
+
+/**
+ * Function used to release the table of a prefetcher.
+ */
+void freePrefetcher(Prefetcher *prefetcher) {
+  free(prefetcher->table);
+  prefetcher->table = NULL;
+}
+
+/**
+ * Function used to forget every stream and stride learned so far.
+ */
+void resetPrefetcher(Prefetcher *prefetcher) {
+  prefetcher->ops->reset(prefetcher);
+}
+
+/**
+ * Function used to find a prefetcher by name, e.g. "stride".
+ * Returns its PREFETCH_* value or -1 if there is none.
+ */
+int parsePrefetcherName(const char *name) {
+  for (int i = 0; i < NUM_PREFETCHERS; i++) {
+    if (strcmp(Prefetchers[i].name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+/**
+ * Function used to get the name of a PREFETCH_* value.
+ */
+const char *prefetcherName(uint32_t type) {
+  return type < NUM_PREFETCHERS ? Prefetchers[type].name : "unknown";
+}
+
+/**
+ * Function used to append the table of a prefetcher to a checkpoint.
+ * Returns 0 on success and -1 on a write error.
+ */
+int savePrefetcher(const Prefetcher *prefetcher, FILE *file) {
+  if (saveBytes(file, prefetcher->table, prefetcher->entries * sizeof(PrefetchEntry)) != 0 ||
+      saveBytes(file, &prefetcher->clock, sizeof(prefetcher->clock)) != 0)
+    return -1;
+  return 0;
+}
+
+/**
+ * Function used to restore the table saved by savePrefetcher() into a
+ * prefetcher of the same type.
+ * Returns 0 on success and -1 if the checkpoint is too short.
+ */
+int loadPrefetcher(Prefetcher *prefetcher, Snapshot *snapshot) {
+  if (loadBytes(snapshot, prefetcher->table, prefetcher->entries * sizeof(PrefetchEntry)) != 0 ||
+      loadBytes(snapshot, &prefetcher->clock, sizeof(prefetcher->clock)) != 0)
+    return -1;
+  return 0;
+}
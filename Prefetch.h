@@ -0,0 +1,73 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <stdint.h>
+#include "Checkpoint.h"
+
+#define PREFETCH_NONE 0
+#define PREFETCH_NEXT_LINE 1   // the blocks right after every trigger
+#define PREFETCH_STRIDE 2      // per-region stride table, no PC needed
+#define PREFETCH_STREAM 3      // stream buffers following runs of misses
+#define NUM_PREFETCHERS 4
+
+#define MAX_PREFETCH_DEGREE 16
+#define STRIDE_ENTRIES 64      // stride table, indexed by region
+#define STRIDE_REGION_SHIFT 6  // regions of 64 blocks
+#define STRIDE_CONFIDENCE 1    // strides seen again before prefetching
+#define STREAM_BUFFERS 8
+#define STREAM_WINDOW 4        // blocks past the head that still follow a stream
+
+typedef struct Prefetcher Prefetcher;
+
+/*
+ * Operations implemented by every prefetcher. Blocks are addresses divided
+ * by the block size. train is called on every trigger, i.e. a demand miss
+ * or the first demand hit on a prefetched line, and stores up to degree
+ * blocks to prefetch into candidates, returning how many.
+ */
+typedef struct PrefetcherOps {
+  const char *name;
+  void (*reset)(Prefetcher *prefetcher);
+  uint32_t (*train)(Prefetcher *prefetcher, uint64_t block, uint64_t *candidates);
+} PrefetcherOps;
+
+/*
+ * One stride table entry or stream buffer. A stride entry follows the
+ * blocks of one region, a stream buffer the head of one stream whose
+ * direction (stride) is 0 until a second miss close to the first one.
+ */
+typedef struct PrefetchEntry {
+  uint64_t tag;           // stride: region, stream: 1 once allocated
+  uint64_t last;          // last block seen
+  int64_t stride;         // in blocks
+  uint32_t confidence;
+  uint64_t used;          // stream: last trigger, for LRU allocation
+} PrefetchEntry;
+
+/*
+ * Prefetcher of one cache level. degree blocks are fetched per trigger,
+ * starting distance blocks ahead of it.
+ */
+struct Prefetcher {
+  const PrefetcherOps *ops;
+  uint32_t type;
+  uint32_t degree;
+  uint32_t distance;
+  uint32_t entries;
+  PrefetchEntry *table;
+  uint64_t clock;
+};
+
+/*********************** Prefetcher *************************/
+
+int initPrefetcher(Prefetcher *prefetcher, uint32_t type, uint32_t degree,
+                   uint32_t distance);
+void freePrefetcher(Prefetcher *prefetcher);
+void resetPrefetcher(Prefetcher *prefetcher);
+int savePrefetcher(const Prefetcher *prefetcher, FILE *file);
+int loadPrefetcher(Prefetcher *prefetcher, Snapshot *snapshot);
+
+int parsePrefetcherName(const char *name);
+const char *prefetcherName(uint32_t type);
+
+#endif
@@ -0,0 +1,340 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Replacement.h"
+
+/**
+ * Function used to draw the next value of the level's xorshift generator.
+ * Seeded with a constant so runs are reproducible.
+ */
+static uint64_t nextRandom(Replacement *replacement) {
+  uint64_t x = replacement->random;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  replacement->random = x;
+  return x;
+}
+
+static uint8_t *setMeta(Replacement *replacement, uint32_t set) {
+  return &replacement->meta[(size_t)set * replacement->metaPerSet];
+}
+
+/***************** True LRU ****************/
+/*
+ * Each set keeps a doubly linked recency list:
+ *   [0] MRU way, [1] LRU way, [2 + way] prev, [2 + ways + way] next
+ * so hits and victim selection are O(1) whatever the associativity.
+ */
+static void lruUnlink(uint16_t *list, uint32_t ways, uint32_t way) {
+  uint16_t *prev = &list[2], *next = &list[2 + ways];
+
+  if (list[0] == way)
+    list[0] = next[way];
+  else
+    next[prev[way]] = next[way];
+
+  if (list[1] == way)
+    list[1] = prev[way];
+  else
+    prev[next[way]] = prev[way];
+}
+
+static void lruReset(Replacement *replacement) {
+  uint32_t ways = replacement->ways;
+
+  for (uint32_t set = 0; set < replacement->sets; set++) {
+    uint16_t *list = (uint16_t *)setMeta(replacement, set);
+    uint16_t *prev = &list[2], *next = &list[2 + ways];
+
+    // Way 0 starts as MRU and way ways-1 as LRU
+    list[0] = 0;
+    list[1] = ways - 1;
+    for (uint32_t way = 0; way < ways; way++) {
+      prev[way] = way - 1;
+      next[way] = way + 1;
+    }
+  }
+}
+
+static void lruTouch(Replacement *replacement, uint32_t set, uint32_t way) {
+  uint16_t *list = (uint16_t *)setMeta(replacement, set);
+  uint32_t ways = replacement->ways;
+
+  if (list[0] == way)
+    return;
+
+  lruUnlink(list, ways, way);
+  list[2 + ways + way] = list[0];
+  list[2 + list[0]] = way;
+  list[0] = way;
+}
+
+static uint32_t lruVictim(Replacement *replacement, uint32_t set) {
+  return ((uint16_t *)setMeta(replacement, set))[1];
+}
+
+/***************** Tree pseudo-LRU ****************/
+/*
+ * Heap ordered binary tree with ways-1 internal nodes (1 is the root, n has
+ * children 2n and 2n+1, leaf ways+w is way w). A node bit of 1 means the
+ * victim is in its right subtree.
+ */
+static int plruBit(const uint8_t *bits, uint32_t node) {
+  return (bits[(node - 1) >> 3] >> ((node - 1) & 7)) & 1;
+}
+
+static void plruSetBit(uint8_t *bits, uint32_t node, int value) {
+  if (value)
+    bits[(node - 1) >> 3] |= 1 << ((node - 1) & 7);
+  else
+    bits[(node - 1) >> 3] &= ~(1 << ((node - 1) & 7));
+}
+
+static void plruReset(Replacement *replacement) {
+  memset(replacement->meta, 0, (size_t)replacement->sets * replacement->metaPerSet);
+}
+
+static void plruTouch(Replacement *replacement, uint32_t set, uint32_t way) {
+  uint8_t *bits = setMeta(replacement, set);
+
+  // Point every node on the path away from the accessed way
+  for (uint32_t node = way + replacement->ways; node > 1; node >>= 1)
+    plruSetBit(bits, node >> 1, !(node & 1));
+}
+
+static uint32_t plruVictim(Replacement *replacement, uint32_t set) {
+  const uint8_t *bits = setMeta(replacement, set);
+  uint32_t node = 1;
+
+  while (node < replacement->ways)
+    node = 2 * node + plruBit(bits, node);
+  return node - replacement->ways;
+}
+
+/***************** FIFO ****************/
+static void fifoReset(Replacement *replacement) {
+  memset(replacement->meta, 0, (size_t)replacement->sets * replacement->metaPerSet);
+}
+
+static void ignoreAccess(Replacement *replacement, uint32_t set, uint32_t way) {
+  (void)replacement;
+  (void)set;
+  (void)way;
+}
+
+static void fifoFill(Replacement *replacement, uint32_t set, uint32_t way) {
+  uint32_t *next = (uint32_t *)setMeta(replacement, set);
+  *next = (way + 1) & (replacement->ways - 1);
+}
+
+static uint32_t fifoVictim(Replacement *replacement, uint32_t set) {
+  return *(uint32_t *)setMeta(replacement, set);
+}
+
+/***************** Random ****************/
+static void randomReset(Replacement *replacement) {
+  replacement->random = 0x9E3779B97F4A7C15ull;
+}
+
+static uint32_t randomVictim(Replacement *replacement, uint32_t set) {
+  (void)set;
+  return nextRandom(replacement) & (replacement->ways - 1);
+}
+
+/***************** RRIP family ****************/
+/*
+ * One re-reference prediction value per way. Hits predict a near
+ * re-reference (0), the victim is the first way predicted distant (RRPV_MAX).
+ */
+static void rripReset(Replacement *replacement) {
+  memset(replacement->meta, RRPV_MAX, (size_t)replacement->sets * replacement->metaPerSet);
+  replacement->psel = 1 << (PSEL_BITS - 1);
+  replacement->random = 0x9E3779B97F4A7C15ull;
+}
+
+static void rripHit(Replacement *replacement, uint32_t set, uint32_t way) {
+  setMeta(replacement, set)[way] = 0;
+}
+
+static uint32_t rripVictim(Replacement *replacement, uint32_t set) {
+  uint8_t *rrpv = setMeta(replacement, set);
+  uint8_t oldest = 0;
+
+  for (uint32_t way = 0; way < replacement->ways; way++) {
+    if (rrpv[way] == RRPV_MAX)
+      return way;
+    if (rrpv[way] > oldest)
+      oldest = rrpv[way];
+  }
+
+  // Age the whole set at once so the oldest ways reach RRPV_MAX
+  uint8_t delta = RRPV_MAX - oldest;
+  uint32_t victim = 0;
+  for (uint32_t way = replacement->ways; way-- > 0;) {
+    rrpv[way] += delta;
+    if (rrpv[way] == RRPV_MAX)
+      victim = way;
+  }
+  return victim;
+}
+
+static void srripFill(Replacement *replacement, uint32_t set, uint32_t way) {
+  setMeta(replacement, set)[way] = RRPV_MAX - 1;
+}
+
+static void brripFill(Replacement *replacement, uint32_t set, uint32_t way) {
+  int longInsert = nextRandom(replacement) % BRRIP_LONG_ODDS == 0;
+  setMeta(replacement, set)[way] = longInsert ? RRPV_MAX - 1 : RRPV_MAX;
+}
+
+/**
+ * Function used to classify a set for DRRIP: 0 for an SRRIP leader, 1 for
+ * a BRRIP leader and -1 for a follower.
+ */
+static int duelLeader(const Replacement *replacement, uint32_t set) {
+  uint32_t stride = replacement->sets / DUEL_LEADER_SETS;
+
+  if (stride < 2)
+    stride = 2;
+  if (set % stride == 0)
+    return 0;
+  if (set % stride == 1)
+    return 1;
+  return -1;
+}
+
+static void drripFill(Replacement *replacement, uint32_t set, uint32_t way) {
+  uint32_t pselMax = (1 << PSEL_BITS) - 1;
+  int leader = duelLeader(replacement, set);
+
+  // Every fill is a miss: charge it to the leader's policy
+  if (leader == 0 && replacement->psel < pselMax)
+    replacement->psel++;
+  if (leader == 1 && replacement->psel > 0)
+    replacement->psel--;
+
+  int useBrrip = leader == 1 ||
+                 (leader == -1 && replacement->psel >= (1u << (PSEL_BITS - 1)));
+  if (useBrrip)
+    brripFill(replacement, set, way);
+  else
+    srripFill(replacement, set, way);
+}
+
+static const ReplacementOps Policies[NUM_POLICIES] = {
+  {"lru", lruReset, lruTouch, lruTouch, lruVictim},
+  {"plru", plruReset, plruTouch, plruTouch, plruVictim},
+  {"fifo", fifoReset, ignoreAccess, fifoFill, fifoVictim},
+  {"random", randomReset, ignoreAccess, ignoreAccess, randomVictim},
+  {"srrip", rripReset, rripHit, srripFill, rripVictim},
+  {"brrip", rripReset, rripHit, brripFill, rripVictim},
+  {"drrip", rripReset, rripHit, drripFill, rripVictim},
+};
+
+/**
+ * Function used to size the per-set metadata of a policy, in bytes.
+ */
+static uint32_t metaSize(uint32_t policy, uint32_t ways) {
+  switch (policy) {
+  case POLICY_LRU:
+    return (2 + 2 * ways) * sizeof(uint16_t);
+  case POLICY_PLRU:
+    return (ways + 7) / 8;
+  case POLICY_FIFO:
+    return sizeof(uint32_t);
+  case POLICY_RANDOM:
+    return 0;
+  default:
+    return ways;
+  }
+}
+
+/************** Interface ***************/
+/**
+ * Function used to allocate the replacement state of a level. ways must be
+ * a power of two (at most 65536 for LRU).
+ * Returns 0 on success and -1 for unknown policies or lack of memory.
+ */
+int initReplacement(Replacement *replacement, uint32_t policy, uint32_t sets,
+                    uint32_t ways) {
+  if (policy >= NUM_POLICIES || (policy == POLICY_LRU && ways > UINT16_MAX + 1))
+    return -1;
+
+  replacement->ops = &Policies[policy];
+  replacement->policy = policy;
+  replacement->sets = sets;
+  replacement->ways = ways;
+  replacement->metaPerSet = metaSize(policy, ways);
+  replacement->meta = NULL;
+
+  if (replacement->metaPerSet != 0) {
+    replacement->meta = calloc(sets, replacement->metaPerSet);
+    if (replacement->meta == NULL)
+      return -1;
+  }
+
+  resetReplacement(replacement);
+  return 0;
+}
+
+/**
+ * Function used to release the metadata of a level.
+ */
+void freeReplacement(Replacement *replacement) {
+  free(replacement->meta);
+  replacement->meta = NULL;
+}
+
+/**
+ * Function used to bring the metadata back to its initial state.
+ */
+void resetReplacement(Replacement *replacement) {
+  replacement->ops->reset(replacement);
+}
+
+/**
+ * Function used to map a policy name (e.g. "drrip") to its POLICY_* value.
+ * Returns -1 for unknown names.
+ */
+int parsePolicyName(const char *name) {
+  for (int i = 0; i < NUM_POLICIES; i++) {
+    if (strcmp(Policies[i].name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+/**
+ * Function used to get the name of a POLICY_* value.
+ */
+const char *policyName(uint32_t policy) {
+  return policy < NUM_POLICIES ? Policies[policy].name : "unknown";
+}
+
+/**
+ * Function used to append the replacement state of a level to a
+ * checkpoint.
+ * Returns 0 on success and -1 on a write error.
+ */
+int saveReplacement(const Replacement *replacement, FILE *file) {
+  if (saveBytes(file, replacement->meta,
+                (size_t)replacement->sets * replacement->metaPerSet) != 0 ||
+      saveBytes(file, &replacement->psel, sizeof(replacement->psel)) != 0 ||
+      saveBytes(file, &replacement->random, sizeof(replacement->random)) != 0)
+    return -1;
+  return 0;
+}
+
+/**
+ * Function used to restore the state saved by saveReplacement() into the
+ * same policy and geometry.
+ * Returns 0 on success and -1 if the checkpoint is too short.
+ */
+int loadReplacement(Replacement *replacement, Snapshot *snapshot) {
+  if (loadBytes(snapshot, replacement->meta,
+                (size_t)replacement->sets * replacement->metaPerSet) != 0 ||
+      loadBytes(snapshot, &replacement->psel, sizeof(replacement->psel)) != 0 ||
+      loadBytes(snapshot, &replacement->random, sizeof(replacement->random)) != 0)
+    return -1;
+  return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef REPLACEMENT_H
+#define REPLACEMENT_H
+
+#include <stdint.h>
+#include "Checkpoint.h"
+
+#define POLICY_LRU 0     // true LRU, one recency rank per way
+#define POLICY_PLRU 1    // tree pseudo-LRU, ways-1 bits per set
+#define POLICY_FIFO 2    // round robin pointer per set
+#define POLICY_RANDOM 3
+#define POLICY_SRRIP 4   // static RRIP, 2-bit RRPV per way
+#define POLICY_BRRIP 5   // bimodal RRIP
+#define POLICY_DRRIP 6   // set dueling between SRRIP and BRRIP
+#define NUM_POLICIES 7
+
+#define RRPV_MAX 3
+#define BRRIP_LONG_ODDS 32     // BRRIP inserts at RRPV_MAX-1 once every 32 fills
+#define DUEL_LEADER_SETS 32    // leader sets per DRRIP component policy
+#define PSEL_BITS 10
+
+typedef struct Replacement Replacement;
+
+/*
+ * Operations implemented by every policy. set/way identify a line, onFill
+ * is called when a missing block is installed and onHit on every later hit.
+ */
+typedef struct ReplacementOps {
+  const char *name;
+  void (*reset)(Replacement *replacement);
+  void (*onHit)(Replacement *replacement, uint32_t set, uint32_t way);
+  void (*onFill)(Replacement *replacement, uint32_t set, uint32_t way);
+  uint32_t (*victim)(Replacement *replacement, uint32_t set);
+} ReplacementOps;
+
+/*
+ * Replacement state of one cache level. meta holds metaPerSet bytes per set
+ * whose meaning depends on the policy.
+ */
+struct Replacement {
+  const ReplacementOps *ops;
+  uint32_t policy;
+  uint32_t sets;
+  uint32_t ways;
+  uint32_t metaPerSet;
+  uint8_t *meta;
+  uint32_t psel;
+  uint64_t random;
+};
+
+/*********************** Replacement *************************/
+
+int initReplacement(Replacement *replacement, uint32_t policy, uint32_t sets,
+                    uint32_t ways);
+void freeReplacement(Replacement *replacement);
+void resetReplacement(Replacement *replacement);
+int saveReplacement(const Replacement *replacement, FILE *file);
+int loadReplacement(Replacement *replacement, Snapshot *snapshot);
+
+int parsePolicyName(const char *name);
+const char *policyName(uint32_t policy);
+
+#endif
@@ -0,0 +1,152 @@
+#include <math.h>
+#include "Sampling.h"
+
+/*
+ * Running sums of the samples of one ratio, e.g. the misses and accesses
+ * of a level in each window, turned into an Estimate once every window has
+ * been measured.
+ */
+typedef struct Accumulator {
+  double x, y;           // numerators and denominators
+  double xx, xy, yy;
+  uint64_t samples;
+} Accumulator;
+
+static void addSample(Accumulator *accumulator, double x, double y) {
+  accumulator->x += x;
+  accumulator->y += y;
+  accumulator->xx += x * x;
+  accumulator->xy += x * y;
+  accumulator->yy += y * y;
+  accumulator->samples++;
+}
+
+/**
+ * Function used to get the ratio estimate sum(x) / sum(y) of the samples
+ * and the half-width of its confidence interval. Windows are weighted by
+ * their denominators, so a level reached only a few times in a window
+ * weighs little, and the variance comes from the residuals x - ratio * y.
+ */
+static Estimate estimate(const Accumulator *accumulator) {
+  Estimate Result = {0, 0, accumulator->samples};
+  double n = (double)accumulator->samples;
+
+  if (accumulator->samples == 0 || accumulator->y == 0)
+    return Result;
+
+  double Ratio = accumulator->x / accumulator->y;
+  double Mean = accumulator->y / n;
+
+  Result.mean = Ratio;
+  if (accumulator->samples > 1) {
+    double Residuals = accumulator->xx - 2 * Ratio * accumulator->xy +
+                       Ratio * Ratio * accumulator->yy;
+    double Variance = Residuals > 0 ? Residuals / (n - 1) : 0;
+    Result.error = SAMPLE_Z * sqrt(Variance / n) / Mean;
+  }
+  return Result;
+}
+
+/**
+ * Function used to warm the caches functionally with the next count
+ * records of a trace.
+ * Returns 0, or -1 if the trace is malformed or the simulator can't be
+ * warmed functionally.
+ */
+static int warmRecords(Simulator *sim, TraceCursor *cursor, uint64_t count) {
+  const TraceRecord *Records;
+  uint64_t n;
+
+  while (count > 0 && (n = nextRecords(cursor, count, &Records)) > 0) {
+    if (warmTrace(sim, Records, n) != 0)
+      return -1;
+    count -= n;
+  }
+  return count == 0 ? 0 : -1;
+}
+
+/**
+ * Function used to simulate the records left in a trace by sampling. Each
+ * period warms the caches functionally up to its last warmup + window
+ * records, simulates those in detail and measures the window: its cycles
+ * per access and the miss rate of every level it reached. Records after
+ * the last full period are only warmed. Counters and time of the simulator
+ * keep running over the detailed parts, as if only those had been
+ * replayed. The trace is read a piece at a time.
+ * Returns 0, or -1 if the periods are too short for their windows, the
+ * trace is malformed or the simulator can't be warmed functionally (see
+ * warmTrace()).
+ */
+int sampleTrace(Simulator *sim, TraceCursor *cursor, const SampleConfig *config,
+                SampleResult *result) {
+  uint32_t Levels = getNumLevels(sim);
+  Accumulator Cycles = {0, 0, 0, 0, 0, 0};
+  Accumulator Misses[MAX_LEVELS] = {{0, 0, 0, 0, 0, 0}};
+  uint64_t Before[MAX_LEVELS][2];
+  uint64_t Detail = config->warmup + config->window;
+  uint64_t Count = cursor->trace->count - cursor->next;
+  uint64_t Position = 0;
+
+  if (config->window == 0 || config->interval < Detail)
+    return -1;
+
+  memset(result, 0, sizeof(*result));
+  result->records = Count;
+  result->numLevels = Levels;
+
+  for (; Count - Position >= config->interval; Position += config->interval) {
+    if (warmRecords(sim, cursor, config->interval - Detail) != 0)
+      return -1;
+    replayRecords(sim, cursor, config->warmup);
+
+    for (uint32_t i = 0; i < Levels; i++) {
+      Before[i][0] = getLevelStats(sim, i)->hits;
+      Before[i][1] = getLevelStats(sim, i)->misses;
+    }
+
+    uint64_t Time = replayRecords(sim, cursor, config->window);
+    if (cursor->failed)
+      return -1;
+    addSample(&Cycles, (double)Time, (double)config->window);
+
+    // Levels the window did not reach give no sample of their miss rate
+    for (uint32_t i = 0; i < Levels; i++) {
+      uint64_t Hits = getLevelStats(sim, i)->hits - Before[i][0];
+      uint64_t Missed = getLevelStats(sim, i)->misses - Before[i][1];
+
+      if (Hits + Missed != 0)
+        addSample(&Misses[i], (double)Missed, (double)(Hits + Missed));
+    }
+
+    result->windows++;
+    result->detailed += Detail;
+  }
+
+  if (warmRecords(sim, cursor, Count - Position) != 0)
+    return -1;
+
+  result->cyclesPerAccess = estimate(&Cycles);
+  result->cycles = result->cyclesPerAccess;
+  result->cycles.mean *= Count;
+  result->cycles.error *= Count;
+  for (uint32_t i = 0; i < Levels; i++)
+    result->missRate[i] = estimate(&Misses[i]);
+  return 0;
+}
+
+/**
+ * Function used to print the estimates of a sampled run, each one as mean
+ * +- the half-width of its 95% confidence interval.
+ */
+void printSampleResult(const SampleResult *result, FILE *file) {
+  fprintf(file, "Windows: %llu; Detailed: %llu of %llu records\n",
+          (unsigned long long)result->windows, (unsigned long long)result->detailed,
+          (unsigned long long)result->records);
+  fprintf(file, "Cycles: %.0f +- %.0f; Per access: %.4f +- %.4f\n", result->cycles.mean,
+          result->cycles.error, result->cyclesPerAccess.mean, result->cyclesPerAccess.error);
+
+  for (uint32_t i = 0; i < result->numLevels; i++)
+    fprintf(file, "L%u miss rate: %.4f +- %.4f (%llu windows)\n", i + 1,
+            result->missRate[i].mean, result->missRate[i].error,
+            (unsigned long long)result->missRate[i].samples);
+}
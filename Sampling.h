@@ -0,0 +1,51 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "Simulator.h"
+
+#define SAMPLE_Z 1.96  // normal quantile of the 95% confidence intervals
+
+/*
+ * SMARTS-style sampled simulation. The trace is cut into periods of
+ * interval records: most of each period is only warmed functionally, then
+ * warmup records are simulated in detail to settle the timing state and
+ * the last window records are simulated in detail and measured. The
+ * measured windows are a systematic sample of the trace, from which the
+ * cycles and miss rates of the whole trace are extrapolated.
+ */
+typedef struct SampleConfig {
+  uint64_t interval;   // records per period
+  uint64_t warmup;     // detailed records before each window, not measured
+  uint64_t window;     // measured records per period
+} SampleConfig;
+
+/*
+ * Estimate of one measure from the windows that sampled it, and the
+ * half-width of its confidence interval: the true value lies in mean +-
+ * error with 95% probability. error is 0 with fewer than 2 samples.
+ */
+typedef struct Estimate {
+  double mean;
+  double error;
+  uint64_t samples;
+} Estimate;
+
+typedef struct SampleResult {
+  uint64_t records;    // in the whole trace
+  uint64_t windows;
+  uint64_t detailed;   // records simulated in detail, warmup included
+  Estimate cyclesPerAccess;
+  Estimate cycles;     // extrapolated to the whole trace
+  uint32_t numLevels;
+  Estimate missRate[MAX_LEVELS];
+} SampleResult;
+
+/*********************** Sampling *************************/
+
+int sampleTrace(Simulator *sim, TraceCursor *cursor, const SampleConfig *config,
+                SampleResult *result);
+void printSampleResult(const SampleResult *result, FILE *file);
+
+#endif
@@ -0,0 +1,1546 @@
+#include "Simulator.h"
+#include "EventQueue.h"
+
+/**************** Simulator ***************/
+/**
+ * Simulator state. Every hierarchy lives in its own instance, so several
+ * simulators can run side by side in one process.
+ * levels[0] is the L1 of the current core, the other levels are shared by
+ * every core and the level after the last one is DRAM.
+ */
+struct Simulator {
+  CacheConfig config;
+  Memory DRAM;
+  LevelStats dramStats;
+  uint64_t time;
+  uint32_t numLevels;
+  uint32_t core;
+  CacheLevel *levels[MAX_LEVELS];
+  CacheLevel l1[MAX_CORES];
+  CacheLevel shared[MAX_LEVELS - 1];
+  CacheLevel victim;      // behind the L1, only set up with victimEntries
+  WriteBuffer writeBuffer;  // behind the L1, only set up with writeBufferEntries
+  LevelStats bufferStats;
+  EventQueue requests;    // completions of the requests in flight
+  uint64_t nextRequest;
+};
+
+/**
+ * Function used to set up one cache level, with its prefetcher and MSHRs,
+ * from its descriptor.
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+static int initLevel(CacheLevel *level, const LevelConfig *descriptor,
+                     const CacheConfig *config) {
+  if (initCacheLevel(level, descriptor->size, config->blockSize, descriptor->ways,
+                     descriptor->policy, descriptor->readTime, descriptor->writeTime,
+                     config->tagOnly, config->statsSample) != 0 ||
+      initPrefetcher(&level->prefetcher, descriptor->prefetcher, config->prefetchDegree,
+                     config->prefetchDistance) != 0 ||
+      initMSHRs(level, descriptor->mshrs) != 0)
+    return -1;
+
+  level->writeThrough = descriptor->writeThrough != 0;
+  level->writeAllocate = descriptor->writeAllocate != 0;
+  return 0;
+}
+
+/**
+ * Function used to allocate a new simulator for the given configuration
+ * (NULL selects modelConfig()). The levels are built in the order they are
+ * listed, an L1 alone being backed directly by DRAM, and cores > 1 gives
+ * each core a private L1 in front of the shared levels.
+ * With tagOnly set neither DRAM nor the cache blocks are allocated: the
+ * simulator tracks hits, misses and time only and read() returns no data.
+ * Returns NULL if the configuration is invalid or there is not enough memory.
+ */
+Simulator *createSimulator(const CacheConfig *config) {
+  Simulator *sim = calloc(1, sizeof(Simulator));
+  if (sim == NULL)
+    return NULL;
+
+  if (config != NULL)
+    sim->config = *config;
+  else
+    modelConfig(&sim->config);
+
+  if (validateConfig(&sim->config) != 0) {
+    free(sim);
+    return NULL;
+  }
+
+  CacheConfig *Config = &sim->config;
+  if ((!Config->tagOnly && initMemory(&sim->DRAM) != 0) || initEventQueue(&sim->requests) != 0) {
+    destroySimulator(sim);
+    return NULL;
+  }
+
+  // numLevels only counts levels once all cores have their L1
+  for (uint32_t c = 0; c < Config->cores; c++) {
+    if (initLevel(&sim->l1[c], &Config->levels[0], Config) != 0) {
+      destroySimulator(sim);
+      return NULL;
+    }
+  }
+  sim->levels[0] = &sim->l1[0];
+  sim->numLevels = 1;
+
+  if (Config->victimEntries != 0 &&
+      initCacheLevel(&sim->victim, Config->victimEntries * Config->blockSize, Config->blockSize,
+                     Config->victimEntries, POLICY_LRU, Config->victimTime,
+                     Config->victimTime, Config->tagOnly, Config->statsSample) != 0) {
+    destroySimulator(sim);
+    return NULL;
+  }
+
+  for (uint32_t i = 1; i < configLevels(Config); i++) {
+    if (initLevel(&sim->shared[i - 1], &Config->levels[i], Config) != 0) {
+      destroySimulator(sim);
+      return NULL;
+    }
+    sim->levels[i] = &sim->shared[i - 1];
+    sim->numLevels = i + 1;
+  }
+
+  if (Config->writeBufferEntries != 0 &&
+      initWriteBuffer(&sim->writeBuffer, Config->writeBufferEntries, Config->blockSize) != 0) {
+    destroySimulator(sim);
+    return NULL;
+  }
+
+  return sim;
+}
+
+/**
+ * Function used to release a simulator created with createSimulator().
+ */
+void destroySimulator(Simulator *sim) {
+  if (sim == NULL)
+    return;
+
+  // Levels that were never set up are still zeroed, which is safe to free
+  for (uint32_t c = 0; c < MAX_CORES; c++)
+    freeCacheLevel(&sim->l1[c]);
+  for (uint32_t i = 0; i < MAX_LEVELS - 1; i++)
+    freeCacheLevel(&sim->shared[i]);
+  freeCacheLevel(&sim->victim);
+  freeWriteBuffer(&sim->writeBuffer);
+  freeEventQueue(&sim->requests);
+  freeMemory(&sim->DRAM);
+  free(sim);
+}
+
+/**************** Time Manipulation ***************/
+void resetTime(Simulator *sim) { sim->time = 0; }
+
+uint64_t getTime(Simulator *sim) { return sim->time; }
+
+
+/****************  RAM memory (byte addressable) ***************/
+/**
+ * Function used to move size bytes to or from DRAM, a block or less for
+ * stores that bypass or write through the last level. DRAM pages are
+ * allocated on their first write, anywhere in the 64-bit address space.
+ */
+static void moveDRAM(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size,
+                     uint32_t mode) {
+  STAT(countTransfer(&sim->dramStats, mode, size));
+
+  // Tag-only simulators have no DRAM contents, only its timing
+  if (mode == MODE_READ) {
+    if (data != NULL)
+      readMemory(&sim->DRAM, address, data, size);
+    sim->time += sim->config.dramReadTime;
+  }
+
+  if (mode == MODE_WRITE) {
+    if (data != NULL && writeMemory(&sim->DRAM, address, data, size) != 0) {
+      fprintf(stderr, "Not enough memory for DRAM page %#llx\n", (unsigned long long)address);
+      exit(-1);
+    }
+    sim->time += sim->config.dramWriteTime;
+  }
+}
+
+/**
+ * Function used to move one block to or from DRAM.
+ */
+void accessDRAM(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode) {
+  moveDRAM(sim, address, data, sim->config.blockSize, mode);
+}
+
+
+/************ Cache hierarchy (byte addressable) **************/
+/**
+ * Function used to initialize every cache level at once, and clear the
+ * statistics.
+ */
+void initCache(Simulator *sim) {
+  for (uint32_t c = 0; c < sim->config.cores; c++)
+    resetCacheLevel(&sim->l1[c]);
+  for (uint32_t i = 1; i < sim->numLevels; i++)
+    resetCacheLevel(sim->levels[i]);
+  if (sim->config.victimEntries != 0)
+    resetCacheLevel(&sim->victim);
+  if (sim->config.writeBufferEntries != 0)
+    resetWriteBuffer(&sim->writeBuffer);
+  resetEventQueue(&sim->requests);
+  sim->nextRequest = 0;
+  resetLevelStats(&sim->bufferStats);
+  resetLevelStats(&sim->dramStats);
+}
+
+/**
+ * Function used to choose the core whose L1 serves the next accesses.
+ */
+void setCore(Simulator *sim, uint32_t core) {
+  sim->core = core;
+  sim->levels[0] = &sim->l1[core];
+}
+
+uint32_t getCore(Simulator *sim) { return sim->core; }
+
+
+/**************** Coherence (MESI) ***************/
+/*
+ * The private L1s snoop each other. A line is Modified when dirty,
+ * Exclusive when clean and not shared, Shared when its shared bit is set
+ * and Invalid when not valid. The L2 below them is kept up to date
+ * whenever a Modified block becomes Shared.
+ */
+
+/**
+ * Function used to serve an L1 miss of the current core from the other
+ * L1s. The first one holding the block supplies it into data. A read leaves
+ * every copy Shared, writing a Modified one back to the L2 first. A write
+ * invalidates every copy, and the requester takes over a Modified block as
+ * is.
+ * Returns 1 if another L1 supplied the block and 0 if the L2 must.
+ */
+static int snoopMiss(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode) {
+  int Supplied = 0, Invalidated = 0;
+
+  for (uint32_t c = 0; c < sim->config.cores; c++) {
+    CacheLevel *Other = &sim->l1[c];
+    uint32_t Line = c == sim->core ? NO_LINE : findLine(Other, address);
+
+    if (Line == NO_LINE)
+      continue;
+
+    if (!Supplied) {
+      if (data != NULL)
+        memcpy(data, lineData(Other, Line), sim->config.blockSize);
+      sim->time += sim->config.c2cTime;
+      STAT(Other->stats.transfers++);
+      Supplied = 1;
+    }
+
+    if (mode == MODE_WRITE) {
+      invalidateLine(Other, Line);
+      STAT(Other->stats.invalidations++);
+      Invalidated = 1;
+    }
+    else {
+      if (Other->dirty[Line]) {
+        accessLevel(sim, 1, address, lineData(Other, Line), sim->config.blockSize, MODE_WRITE);
+        Other->dirty[Line] = 0;
+      }
+      Other->shared[Line] = 1;
+    }
+  }
+
+  if (Invalidated)
+    sim->time += sim->config.invalidateTime;
+  return Supplied;
+}
+
+/**
+ * Function used to turn a Shared line of the current core into a Modified
+ * one, invalidating the copies of the other cores.
+ */
+static void upgradeLine(Simulator *sim, CacheLevel *level, uint32_t line, uint64_t address) {
+  for (uint32_t c = 0; c < sim->config.cores; c++) {
+    CacheLevel *Other = &sim->l1[c];
+    uint32_t Line = c == sim->core ? NO_LINE : findLine(Other, address);
+
+    if (Line != NO_LINE) {
+      invalidateLine(Other, Line);
+      STAT(Other->stats.invalidations++);
+    }
+  }
+
+  level->shared[line] = 0;
+  sim->time += sim->config.upgradeTime;
+  STAT(level->stats.upgrades++);
+}
+
+
+/**************** Write buffer ***************/
+/*
+ * Stores leaving the L1, write-through or bypassing it, wait in the write
+ * buffer while the L1 goes on. Stores to a block already waiting merge
+ * with it. The entries drain one by one in the background: the head starts
+ * draining once the previous one is done and holds its entry until its
+ * stores reach the next level. A store finding the buffer full waits for
+ * the head, and L1 misses wait until the stores to their block are out.
+ */
+
+/**
+ * Function used to drain the head of the write buffer: its stores go to
+ * the next level, one run of written bytes at a time, without charging
+ * the time it takes.
+ */
+static void startDrain(Simulator *sim) {
+  WriteBuffer *Buffer = &sim->writeBuffer;
+  uint32_t Entry = Buffer->head;
+  uint32_t BlockSize = Buffer->blockSize;
+  uint8_t *Data = &Buffer->data[(size_t)Entry * BlockSize];
+  uint8_t *Mask = &Buffer->mask[(size_t)Entry * BlockSize];
+  uint64_t Now = sim->time;
+  uint64_t Start = Buffer->busy > Buffer->arrival[Entry] ? Buffer->busy : Buffer->arrival[Entry];
+
+  for (uint32_t first = 0; first < BlockSize; first++) {
+    uint32_t last = first;
+
+    if (!Mask[first])
+      continue;
+    while (last + 1 < BlockSize && Mask[last + 1])
+      last++;
+    accessLevel(sim, 1, Buffer->blocks[Entry] + first, sim->config.tagOnly ? NULL : &Data[first],
+                last - first + 1, MODE_WRITE);
+    first = last;
+  }
+
+  STAT(sim->bufferStats.evictions++);
+  Buffer->busy = Start + (sim->time - Now);
+  Buffer->draining = 1;
+  sim->time = Now;
+}
+
+/**
+ * Function used to bring the write buffer up to the current time: drained
+ * entries leave it and the next one starts draining.
+ */
+static void advanceWriteBuffer(Simulator *sim) {
+  WriteBuffer *Buffer = &sim->writeBuffer;
+
+  while (Buffer->count != 0 && Buffer->busy <= sim->time) {
+    if (Buffer->draining)
+      popEntry(Buffer);
+    else
+      startDrain(sim);
+  }
+}
+
+/**
+ * Function used to wait until the head of the write buffer has drained.
+ */
+static void waitWriteBuffer(Simulator *sim) {
+  WriteBuffer *Buffer = &sim->writeBuffer;
+
+  if (!Buffer->draining)
+    startDrain(sim);
+  if (Buffer->busy > sim->time)
+    sim->time = Buffer->busy;
+  advanceWriteBuffer(sim);
+}
+
+/**
+ * Function used to queue a store in the write buffer, merged with the
+ * stores already waiting for its block if possible.
+ */
+static void bufferStore(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size) {
+  WriteBuffer *Buffer = &sim->writeBuffer;
+  uint32_t Offset = getOffset(&sim->levels[0]->geometry, address);
+  uint32_t Entry;
+
+  advanceWriteBuffer(sim);
+  Entry = findEntry(Buffer, address - Offset, 1);
+  STAT(countAccess(&sim->bufferStats, 0, MODE_WRITE, size, Entry != NO_ENTRY));
+
+  if (Entry == NO_ENTRY) {
+    if (Buffer->count == Buffer->entries) {
+      STAT(sim->bufferStats.stalls++);
+      waitWriteBuffer(sim);
+    }
+    Entry = pushEntry(Buffer, address - Offset, sim->time);
+  }
+  mergeStore(Buffer, Entry, Offset, data, size);
+}
+
+/**
+ * Function used to wait until no store to the block of address is left in
+ * the write buffer, before the L1 fetches it.
+ */
+static void flushWriteBuffer(Simulator *sim, uint64_t address) {
+  advanceWriteBuffer(sim);
+  while (findEntry(&sim->writeBuffer, address, 0) != NO_ENTRY)
+    waitWriteBuffer(sim);
+}
+
+/**
+ * Function used to send a store on to the level after level, for
+ * write-through levels and store misses that bypass them. L1 stores go
+ * through the write buffer if there is one.
+ */
+static void forwardStore(Simulator *sim, uint32_t level, uint64_t address, uint8_t *data,
+                         uint32_t size) {
+  // Tag-only simulators have no DRAM to take the caller's data
+  if (sim->config.tagOnly)
+    data = NULL;
+
+  if (level == 0 && sim->config.writeBufferEntries != 0)
+    bufferStore(sim, address, data, size);
+  else
+    accessLevel(sim, level + 1, address, data, size, MODE_WRITE);
+}
+
+
+/**************** Victim buffer ***************/
+/*
+ * Small fully associative buffer holding the blocks evicted from the L1.
+ * An L1 miss that finds its block there swaps it with the L1 victim for
+ * victimTime instead of going to the next level. Exclusive levels are
+ * handled the same way, as victim caches of the level above them.
+ */
+
+/**
+ * Function used to look the block of address up in a victim cache. On a
+ * hit the block is copied into data and leaves the cache.
+ * Returns 0 on a miss, 1 on a hit and 2 on a hit on a dirty block.
+ */
+static int takeVictim(Simulator *sim, CacheLevel *victim, uint64_t address, uint8_t *data) {
+  uint32_t Line = findLine(victim, address);
+  int Hit;
+
+  STAT(countAccess(&victim->stats, getIndex(&victim->geometry, address), MODE_READ,
+                   sim->config.blockSize, Line != NO_LINE));
+  if (Line == NO_LINE)
+    return 0;
+
+  if (data != NULL)
+    memcpy(data, lineData(victim, Line), sim->config.blockSize);
+  Hit = victim->dirty[Line] ? 2 : 1;
+  invalidateLine(victim, Line);
+  sim->time += victim->readTime;
+  return Hit;
+}
+
+/**
+ * Function used to move a block evicted from the level above into a victim
+ * cache. The block it replaces is written back to level next first if
+ * dirty. A block the cache already holds is only updated.
+ */
+static void putVictim(Simulator *sim, CacheLevel *victim, uint32_t next, uint64_t address,
+                      uint8_t *data, int dirty) {
+  uint32_t Line = findLine(victim, address);
+
+  STAT(countTransfer(&victim->stats, MODE_WRITE, sim->config.blockSize));
+
+  if (Line != NO_LINE) {
+    dirty |= victim->dirty[Line];
+  }
+  else {
+    Line = victimLine(victim, address);
+    STAT(victim->stats.evictions += victim->valid[Line]);
+    STAT(victim->stats.writebacks += victim->valid[Line] && victim->dirty[Line]);
+
+    if (victim->valid[Line] && victim->dirty[Line]) {
+      uint64_t oldAddress = getOldAddress(&victim->geometry, address, victim->tags[Line]);
+      accessLevel(sim, next, oldAddress, lineData(victim, Line), sim->config.blockSize,
+                  MODE_WRITE);
+    }
+  }
+
+  if (data != NULL)
+    memcpy(lineData(victim, Line), data, sim->config.blockSize);
+  installLine(victim, Line, address);
+  victim->dirty[Line] = dirty;
+}
+
+
+/**************** Inclusion ***************/
+/*
+ * An inclusive level holds every block of the levels above it, the victim
+ * buffer included, so a block leaving it is invalidated above it first.
+ * An exclusive level only holds blocks the level above it does not: every
+ * victim of that level moves into it, clean or dirty, and its blocks move
+ * up on a hit. A NINE level keeps a copy of what it supplies and leaves
+ * the levels above it alone.
+ */
+
+/**
+ * Function used to tell whether a level exists and has the given
+ * INCLUSION_* policy.
+ */
+static int hasInclusion(Simulator *sim, uint32_t level, uint32_t inclusion) {
+  return level < sim->numLevels && sim->config.levels[level].inclusion == inclusion;
+}
+
+/**
+ * Function used to invalidate the copy of a block held in a cache above
+ * the line of level holding it. A dirty copy is newer than the line, so
+ * its data moves into the line, which becomes dirty. Only counted when
+ * counted is set.
+ */
+static void dropCopy(Simulator *sim, CacheLevel *above, CacheLevel *level, uint32_t line,
+                     uint64_t address, int counted) {
+  uint32_t Line = findLine(above, address);
+
+  if (Line == NO_LINE)
+    return;
+
+  if (above->dirty[Line]) {
+    if (level->data != NULL)
+      memcpy(lineData(level, line), lineData(above, Line), sim->config.blockSize);
+    level->dirty[line] = 1;
+  }
+  invalidateLine(above, Line);
+  if (counted)
+    STAT(above->stats.invalidations++);
+}
+
+/**
+ * Function used to invalidate every copy above an inclusive level of the
+ * block in one of its lines. Copies closer to the cores are newer, so they
+ * are dropped last. counted is 0 while warming, which leaves the counters
+ * alone.
+ */
+static void backInvalidate(Simulator *sim, uint32_t level, uint32_t line, uint64_t address,
+                           int counted) {
+  CacheLevel *Level = sim->levels[level];
+
+  for (uint32_t i = level - 1; i > 0; i--)
+    dropCopy(sim, sim->levels[i], Level, line, address, counted);
+  if (sim->config.victimEntries != 0)
+    dropCopy(sim, &sim->victim, Level, line, address, counted);
+  for (uint32_t c = 0; c < sim->config.cores; c++)
+    dropCopy(sim, &sim->l1[c], Level, line, address, counted);
+}
+
+/**
+ * Function used to fetch the block of address for a miss in level. An
+ * exclusive level below gives its block up, other levels keep a copy of
+ * what they supply.
+ * Returns 0, or like takeVictim() when an exclusive level had the block.
+ */
+static int fetchBlock(Simulator *sim, uint32_t level, uint64_t address, uint8_t *data) {
+  if (hasInclusion(sim, level + 1, INCLUSION_EXCLUSIVE)) {
+    CacheLevel *Below = sim->levels[level + 1];
+    int Hit = takeVictim(sim, Below, address, data);
+
+    if (Hit != 0)
+      return Hit;
+    sim->time += Below->readTime;    // the lookup that missed
+    level++;
+  }
+
+  accessLevel(sim, level + 1, address, data, sim->config.blockSize, MODE_READ);
+  return 0;
+}
+
+/**
+ * Function used to make room in a line for the block of address. Blocks
+ * go to the victim buffer or an exclusive level below when there is one,
+ * and the copies above an inclusive level are invalidated. Dirty blocks
+ * are then written back to the next level. The old address is rebuilt
+ * from the stored tag and the index of the new one.
+ */
+static void retireLine(Simulator *sim, uint32_t level, uint32_t line, uint64_t address) {
+  CacheLevel *Level = sim->levels[level];
+
+  if (!Level->valid[line])
+    return;
+
+  uint64_t oldAddress = getOldAddress(&Level->geometry, address, Level->tags[line]);
+  if (level == 0 && sim->config.victimEntries != 0) {
+    putVictim(sim, &sim->victim, 1, oldAddress, lineData(Level, line), Level->dirty[line]);
+    return;
+  }
+  if (hasInclusion(sim, level + 1, INCLUSION_EXCLUSIVE)) {
+    putVictim(sim, sim->levels[level + 1], level + 2, oldAddress, lineData(Level, line),
+              Level->dirty[line]);
+    sim->time += sim->levels[level + 1]->writeTime;
+    return;
+  }
+
+  if (level != 0 && hasInclusion(sim, level, INCLUSION_INCLUSIVE))
+    backInvalidate(sim, level, line, oldAddress, 1);
+
+  if (Level->dirty[line])
+    accessLevel(sim, level + 1, oldAddress, lineData(Level, line), sim->config.blockSize,
+                MODE_WRITE);
+}
+
+
+/**************** Prefetching ***************/
+
+/**
+ * Function used to tell whether another core's L1 holds the block of
+ * address. Prefetches leave those blocks alone rather than snoop for them.
+ */
+static int heldByOtherCore(Simulator *sim, uint64_t address) {
+  for (uint32_t c = 0; c < sim->config.cores; c++) {
+    if (c != sim->core && findLine(&sim->l1[c], address) != NO_LINE)
+      return 1;
+  }
+  return 0;
+}
+
+/**
+ * Function used to bring the block of address into a level ahead of the
+ * demand accesses. The fetch runs in the background: its time is not
+ * charged now, the line is only ready when the block would have arrived.
+ */
+static void prefetchBlock(Simulator *sim, uint32_t level, uint64_t address) {
+  CacheLevel *Level = sim->levels[level];
+
+  if (findLine(Level, address) != NO_LINE ||
+      (level == 0 && sim->config.cores > 1 && heldByOtherCore(sim, address)) ||
+      (level == 0 && sim->config.victimEntries != 0 &&
+       findLine(&sim->victim, address) != NO_LINE) ||
+      (level == 0 && sim->config.writeBufferEntries != 0 &&
+       findEntry(&sim->writeBuffer, address, 0) != NO_ENTRY))
+    return;
+
+  // Prefetches only use MSHRs left free by demand misses
+  if (findMSHR(Level, address, sim->time) != NO_MSHR ||
+      freeMSHRTime(Level, sim->time) > sim->time)
+    return;
+
+  uint8_t TempBlock[MAX_BLOCK_SIZE];
+  uint8_t *Fill = Level->data != NULL ? TempBlock : NULL;
+  uint64_t Issued = sim->time, Ready;
+  uint32_t Line = victimLine(Level, address);
+  int Swapped;
+
+  STAT(Level->stats.prefetches++);
+  STAT(Level->stats.evictions += Level->valid[Line]);
+  STAT(Level->stats.writebacks += Level->valid[Line] && Level->dirty[Line]);
+  STAT(Level->stats.uselessPrefetches += Level->valid[Line] && Level->prefetched[Line]);
+
+  Swapped = fetchBlock(sim, level, address, Fill);
+  Ready = sim->time;
+  retireLine(sim, level, Line, address);
+  sim->time = Issued;
+  allocateMSHR(Level, address, Issued, Ready);
+
+  if (Fill != NULL)
+    memcpy(lineData(Level, Line), TempBlock, sim->config.blockSize);
+  installLine(Level, Line, address);
+  Level->dirty[Line] = Swapped == 2;
+  Level->prefetched[Line] = 1;
+  Level->ready[Line] = Ready;
+}
+
+/**
+ * Function used to train the prefetcher of a level on a trigger at address
+ * and issue the prefetches it asks for.
+ */
+static void trainPrefetcher(Simulator *sim, uint32_t level, uint64_t address) {
+  CacheLevel *Level = sim->levels[level];
+  int Shift = Level->geometry.indexShift;
+  uint64_t Candidates[MAX_PREFETCH_DEGREE];
+  uint32_t Count = Level->prefetcher.ops->train(&Level->prefetcher, address >> Shift,
+                                                Candidates);
+
+  for (uint32_t i = 0; i < Count; i++)
+    prefetchBlock(sim, level, Candidates[i] << Shift);
+}
+
+/**
+ * Function used to access one level of the hierarchy. Moves size bytes
+ * starting at address, which must not cross a block boundary. Misses are
+ * served by the next level, and the level after the last one is DRAM.
+ * Store misses skip the level when it does not allocate on writes.
+ */
+void accessLevel(Simulator *sim, uint32_t level, uint64_t address, uint8_t *data,
+                 uint32_t size, uint32_t mode) {
+  if (level == sim->numLevels) {
+    moveDRAM(sim, address, data, size, mode);
+    return;
+  }
+
+  CacheLevel *Level = sim->levels[level];
+  int Coherent = level == 0 && sim->config.cores > 1;
+  int Supplied = 0, Swapped = 0, Trigger = 0;
+  uint32_t Offset = getOffset(&Level->geometry, address);
+  uint32_t Line = findLine(Level, address);
+
+  STAT(countAccess(&Level->stats, getIndex(&Level->geometry, address), mode, size,
+                   Line != NO_LINE));
+
+  // No-write-allocate: the store goes around the level, unless the victim
+  // buffer can bring the block back
+  if (Line == NO_LINE && mode == MODE_WRITE && !Level->writeAllocate &&
+      !(level == 0 && sim->config.victimEntries != 0 &&
+        findLine(&sim->victim, address) != NO_LINE)) {
+    sim->time += Level->writeTime;
+    forwardStore(sim, level, address, data, size);
+    return;
+  }
+
+  // Cache miss -> Replace with the correct block
+  if (Line == NO_LINE) {
+    uint8_t TempBlock[MAX_BLOCK_SIZE];
+    uint8_t *Fill = Level->data != NULL ? TempBlock : NULL;
+
+    if (level == 0 && sim->config.writeBufferEntries != 0)
+      flushWriteBuffer(sim, address - Offset);
+
+    // A miss to a block already in flight only waits for it, others need a
+    // free MSHR
+    uint32_t Pending = findMSHR(Level, address, sim->time);
+    uint64_t Issued;
+
+    if (Pending == NO_MSHR && freeMSHRTime(Level, sim->time) > sim->time) {
+      STAT(Level->stats.stalls++);
+      sim->time = freeMSHRTime(Level, sim->time);
+    }
+    Issued = sim->time;
+
+    Line = victimLine(Level, address);
+    STAT(Level->stats.evictions += Level->valid[Line]);
+    STAT(Level->stats.writebacks += Level->valid[Line] && Level->dirty[Line]);
+    STAT(Level->stats.uselessPrefetches += Level->valid[Line] && Level->prefetched[Line]);
+
+    // Get the new block from another core, the victim buffer or the next
+    // level
+    if (Coherent)
+      Supplied = snoopMiss(sim, address - Offset, Fill, mode);
+    if (!Supplied && level == 0 && sim->config.victimEntries != 0)
+      Swapped = takeVictim(sim, &sim->victim, address - Offset, Fill);
+    if (!Supplied && !Swapped)
+      Swapped = fetchBlock(sim, level, address - Offset, Fill);
+
+    // The block arrives with the miss in flight, the fetch above only
+    // provides its data
+    if (Pending != NO_MSHR) {
+      STAT(Level->stats.merges++);
+      sim->time = Issued > Level->mshrReady[Pending] ? Issued : Level->mshrReady[Pending];
+    }
+    else {
+      allocateMSHR(Level, address, Issued, sim->time);
+    }
+    uint64_t Ready = sim->time;
+
+    // Write the old block back, or move it to the victim buffer
+    retireLine(sim, level, Line, address - Offset);
+
+    // Copy new block to cache line
+    if (Fill != NULL)
+      memcpy(lineData(Level, Line), TempBlock, sim->config.blockSize);
+    installLine(Level, Line, address);
+    Level->shared[Line] = Supplied && mode == MODE_READ;
+    Level->dirty[Line] = Swapped == 2;
+    Level->ready[Line] = Ready;
+    Trigger = 1;
+  }
+  else {
+    touchLine(Level, Line);
+
+    // First use of a prefetched block, which may still be on its way
+    if (Level->prefetched[Line]) {
+      Level->prefetched[Line] = 0;
+      STAT(Level->stats.usefulPrefetches++);
+      if (Level->ready[Line] > sim->time) {
+        STAT(Level->stats.latePrefetches++);
+        sim->time = Level->ready[Line];
+      }
+      Trigger = 1;
+    }
+    else if (Level->ready[Line] > sim->time) {
+      // Secondary miss, merged with the one bringing the block in
+      STAT(Level->stats.merges++);
+      sim->time = Level->ready[Line];
+    }
+    if (Coherent && mode == MODE_WRITE && Level->shared[Line])
+      upgradeLine(sim, Level, Line, address);
+  }
+
+  uint8_t *Block = lineData(Level, Line);
+
+  if (mode == MODE_READ) {    // read data from cache line
+    if (Block != NULL)
+      memcpy(data, &Block[Offset], size);
+    sim->time += Level->readTime;
+  }
+
+  if (mode == MODE_WRITE) {   // write data to cache line
+    if (Block != NULL)
+      memcpy(&Block[Offset], data, size);
+    sim->time += Level->writeTime;
+    if (Level->writeThrough)
+      forwardStore(sim, level, address, data, size);
+    else
+      Level->dirty[Line] = 1;
+  }
+
+  if (Trigger && Level->prefetcher.type != PREFETCH_NONE)
+    trainPrefetcher(sim, level, address);
+}
+
+/**
+ * Function used to access L1 cache, one word at a time.
+ */
+void accessL1(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode) {
+  accessLevel(sim, 0, address, data, WORD_SIZE, mode);
+}
+
+/**
+ * Function used to access L2 cache (or DRAM if there is no L2), one block
+ * at a time.
+ */
+void accessL2(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode) {
+  accessLevel(sim, 1, address, data, sim->config.blockSize, mode);
+}
+
+void read(Simulator *sim, uint64_t address, uint8_t *data) {
+  accessL1(sim, address, data, MODE_READ);
+}
+
+void write(Simulator *sim, uint64_t address, uint8_t *data) {
+  accessL1(sim, address, data, MODE_WRITE);
+}
+
+
+/**************** Sized accesses ***************/
+/*
+ * Accesses of any size and alignment are split at block boundaries, each
+ * piece being an L1 access of its own. The pieces run one after the other,
+ * so an access crossing two blocks pays for both.
+ */
+
+/**
+ * Function used to get how many of the size bytes at address fall in the
+ * block of address.
+ */
+static uint32_t blockPiece(Simulator *sim, uint64_t address, uint64_t size) {
+  uint32_t Left = sim->config.blockSize - (uint32_t)(address & (sim->config.blockSize - 1));
+  return size < Left ? (uint32_t)size : Left;
+}
+
+/**
+ * Function used to move size bytes starting at any address, e.g. a byte, an
+ * unaligned word or a 32-byte vector.
+ */
+void accessBytes(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size,
+                 uint32_t mode) {
+  while (size > 0) {
+    uint32_t Piece = blockPiece(sim, address, size);
+
+    accessLevel(sim, 0, address, data, Piece, mode);
+    address += Piece;
+    data += Piece;
+    size -= Piece;
+  }
+}
+
+void readBytes(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size) {
+  accessBytes(sim, address, data, size, MODE_READ);
+}
+
+void writeBytes(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size) {
+  accessBytes(sim, address, data, size, MODE_WRITE);
+}
+
+/**
+ * Function used to copy size bytes from source to destination through the
+ * hierarchy, like memcpy(). Each piece is read then written, and ends
+ * where a block of either range does.
+ */
+void copyBytes(Simulator *sim, uint64_t destination, uint64_t source, uint64_t size) {
+  uint8_t Buffer[MAX_BLOCK_SIZE];
+
+  while (size > 0) {
+    uint32_t Piece = blockPiece(sim, source, size);
+    Piece = blockPiece(sim, destination, Piece);
+
+    accessLevel(sim, 0, source, Buffer, Piece, MODE_READ);
+    accessLevel(sim, 0, destination, Buffer, Piece, MODE_WRITE);
+    source += Piece;
+    destination += Piece;
+    size -= Piece;
+  }
+}
+
+/**
+ * Function used to set size bytes starting at address to value through the
+ * hierarchy, like memset(), one block at a time.
+ */
+void setBytes(Simulator *sim, uint64_t address, uint8_t value, uint64_t size) {
+  uint8_t Buffer[MAX_BLOCK_SIZE];
+
+  memset(Buffer, value, sim->config.blockSize);
+  while (size > 0) {
+    uint32_t Piece = blockPiece(sim, address, size);
+
+    accessLevel(sim, 0, address, Buffer, Piece, MODE_WRITE);
+    address += Piece;
+    size -= Piece;
+  }
+}
+
+/**
+ * Function used to get the bytes a trace record writes: the address
+ * itself, repeated over the size of the record. Records without a size
+ * are words.
+ * Returns the size of the record.
+ */
+static uint32_t recordData(const TraceRecord *record, uint8_t *bytes) {
+  uint32_t Size = record->size != 0 ? record->size : WORD_SIZE;
+
+  for (uint32_t i = 0; i < Size; i++)
+    bytes[i] = (uint8_t)(record->address >> (8 * (i % sizeof(uint64_t))));
+  return Size;
+}
+
+/**
+ * Function used to run count word accesses in one call, the equivalent of
+ * calling read() or write() for each of them in order. Word i is read into
+ * or written from data[i * WORD_SIZE].
+ * Runs of accesses to the same L1 block skip the address decode and the
+ * tag lookup: the block stays in L1 until the next miss, and hitting the
+ * line that was just used again leaves every replacement policy unchanged.
+ * Misses and first hits on prefetched lines, which may prefetch other
+ * blocks, take the full path.
+ * Returns the time spent by the whole batch.
+ */
+uint64_t accessBatch(Simulator *sim, const uint64_t *addresses, const uint8_t *modes,
+                     uint8_t *data, size_t count) {
+  CacheLevel *Level = sim->levels[0];
+  const CacheGeometry *Geometry = &Level->geometry;
+  uint64_t Start = sim->time;
+  uint64_t Time = 0;
+  uint64_t LastBlock = 0;
+  uint32_t Line = NO_LINE;
+  uint8_t *Block = NULL;
+
+  for (size_t i = 0; i < count; i++) {
+    uint64_t address = addresses[i];
+    uint8_t *word = &data[i * WORD_SIZE];
+
+    if (Line == NO_LINE || (address >> Geometry->indexShift) != LastBlock) {
+      Line = findLine(Level, address);
+
+      // Misses go through the full hierarchy, the next access looks the
+      // installed block up again. So do blocks still on their way.
+      if (Line == NO_LINE || Level->prefetched[Line] || Level->ready[Line] > sim->time + Time) {
+        sim->time += Time;
+        Time = 0;
+        accessLevel(sim, 0, address, word, WORD_SIZE, modes[i]);
+        Line = NO_LINE;
+        continue;
+      }
+
+      touchLine(Level, Line);
+      LastBlock = address >> Geometry->indexShift;
+      Block = lineData(Level, Line);
+    }
+
+    // Writes to Shared lines need the coherence upgrade, and write-through
+    // ones go on to the next level, where an inclusive L2 may take the line
+    // back
+    if (modes[i] == MODE_WRITE && (Level->shared[Line] || Level->writeThrough)) {
+      sim->time += Time;
+      Time = 0;
+      accessLevel(sim, 0, address, word, WORD_SIZE, MODE_WRITE);
+      Line = NO_LINE;
+      continue;
+    }
+
+    uint32_t Offset = getOffset(Geometry, address);
+
+    STAT(countAccess(&Level->stats, getIndex(Geometry, address), modes[i], WORD_SIZE, 1));
+
+    if (modes[i] == MODE_READ) {
+      if (Block != NULL)
+        memcpy(word, &Block[Offset], WORD_SIZE);
+      Time += Level->readTime;
+    }
+    else {
+      if (Block != NULL)
+        memcpy(&Block[Offset], word, WORD_SIZE);
+      Time += Level->writeTime;
+      Level->dirty[Line] = 1;
+    }
+  }
+
+  sim->time += Time;
+  return sim->time - Start;
+}
+
+/**
+ * Function used to replay trace records through accessBatch(), BATCH_SIZE
+ * at a time. Records of other sizes and unaligned words run on their own,
+ * after the batch so far. Writes store the address itself.
+ * Returns the time spent by the whole replay.
+ */
+uint64_t replayTrace(Simulator *sim, const TraceRecord *records, uint64_t count) {
+  uint64_t addresses[BATCH_SIZE];
+  uint32_t values[BATCH_SIZE];
+  uint8_t modes[BATCH_SIZE];
+  uint8_t bytes[UINT8_MAX];
+  uint64_t Start = sim->time;
+  size_t n = 0;
+
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t address = records[i].address;
+    uint32_t mode = records[i].mode == MODE_READ ? MODE_READ : MODE_WRITE;
+
+    if ((records[i].size != 0 && records[i].size != WORD_SIZE) || address % WORD_SIZE != 0) {
+      accessBatch(sim, addresses, modes, (uint8_t *)values, n);
+      n = 0;
+      accessBytes(sim, address, bytes, recordData(&records[i], bytes), mode);
+      continue;
+    }
+
+    addresses[n] = address;
+    modes[n] = mode;
+    values[n] = (uint32_t)address;
+    if (++n == BATCH_SIZE) {
+      accessBatch(sim, addresses, modes, (uint8_t *)values, n);
+      n = 0;
+    }
+  }
+  accessBatch(sim, addresses, modes, (uint8_t *)values, n);
+
+  return sim->time - Start;
+}
+
+/**
+ * Function used to replay the next count records of a trace, a piece at a
+ * time, or every record left with count UINT64_MAX.
+ * Returns the time spent. Malformed traces stop the replay and set the
+ * failed flag of the cursor.
+ */
+uint64_t replayRecords(Simulator *sim, TraceCursor *cursor, uint64_t count) {
+  const TraceRecord *Records;
+  uint64_t Start = sim->time, n;
+
+  while (count > 0 && (n = nextRecords(cursor, count, &Records)) > 0) {
+    replayTrace(sim, Records, n);
+    count -= n;
+  }
+  return sim->time - Start;
+}
+
+/**
+ * Function used to replay one trace per core, interleaved round robin:
+ * core 0 runs quantum records, then core 1, and so on until every trace
+ * is done. The order only depends on the traces and the quantum, so runs
+ * are reproducible.
+ * Returns the time spent by the whole replay. Malformed traces stop early
+ * and set the failed flag of their cursor.
+ */
+uint64_t replayInterleaved(Simulator *sim, TraceCursor *cursors, uint32_t cores) {
+  uint64_t Start = sim->time;
+  uint32_t quantum = sim->config.quantum;
+  int Active = 1;
+
+  if (cores == 1)
+    return replayRecords(sim, &cursors[0], UINT64_MAX);
+
+  while (Active) {
+    Active = 0;
+    for (uint32_t c = 0; c < cores; c++) {
+      if (cursors[c].failed || cursors[c].next == cursors[c].trace->count)
+        continue;
+      setCore(sim, c);
+      replayRecords(sim, &cursors[c], quantum);
+      Active = 1;
+    }
+  }
+
+  setCore(sim, 0);
+  return sim->time - Start;
+}
+
+
+/*********************** Functional warming *************************/
+/*
+ * Fast path for the parts of a trace that are not measured: accesses only
+ * update the tags, dirty bits and replacement state of the levels, with
+ * the same inclusion and victim buffer rules as accessLevel(). Time stands
+ * still, no data moves and the prefetchers, MSHRs, write buffer and
+ * counters are left alone, so the blocks it brings in are ready at once.
+ */
+
+static void warmLevel(Simulator *sim, uint32_t level, uint64_t address, uint32_t mode);
+
+/**
+ * Function used to move a block evicted from the level above into a victim
+ * cache, like putVictim().
+ */
+static void warmVictim(Simulator *sim, CacheLevel *victim, uint32_t next, uint64_t address,
+                       int dirty) {
+  uint32_t Line = findLine(victim, address);
+
+  if (Line != NO_LINE) {
+    dirty |= victim->dirty[Line];
+  }
+  else {
+    Line = victimLine(victim, address);
+    if (victim->valid[Line] && victim->dirty[Line])
+      warmLevel(sim, next, getOldAddress(&victim->geometry, address, victim->tags[Line]),
+                MODE_WRITE);
+  }
+
+  installLine(victim, Line, address);
+  victim->dirty[Line] = dirty;
+  victim->ready[Line] = 0;
+}
+
+/**
+ * Function used to take the block of address out of a victim cache, like
+ * takeVictim().
+ * Returns 0 on a miss, 1 on a hit and 2 on a hit on a dirty block.
+ */
+static int warmTake(CacheLevel *victim, uint64_t address) {
+  uint32_t Line = findLine(victim, address);
+  int Hit;
+
+  if (Line == NO_LINE)
+    return 0;
+  Hit = victim->dirty[Line] ? 2 : 1;
+  invalidateLine(victim, Line);
+  return Hit;
+}
+
+/**
+ * Function used to make room in a line of level, like retireLine().
+ */
+static void warmRetire(Simulator *sim, uint32_t level, uint32_t line, uint64_t address) {
+  CacheLevel *Level = sim->levels[level];
+
+  if (!Level->valid[line])
+    return;
+
+  uint64_t oldAddress = getOldAddress(&Level->geometry, address, Level->tags[line]);
+  if (level == 0 && sim->config.victimEntries != 0) {
+    warmVictim(sim, &sim->victim, 1, oldAddress, Level->dirty[line]);
+    return;
+  }
+  if (hasInclusion(sim, level + 1, INCLUSION_EXCLUSIVE)) {
+    warmVictim(sim, sim->levels[level + 1], level + 2, oldAddress, Level->dirty[line]);
+    return;
+  }
+
+  if (level != 0 && hasInclusion(sim, level, INCLUSION_INCLUSIVE))
+    backInvalidate(sim, level, line, oldAddress, 0);
+
+  if (Level->dirty[line])
+    warmLevel(sim, level + 1, oldAddress, MODE_WRITE);
+}
+
+/**
+ * Function used to warm one level with an access to the block of address.
+ */
+static void warmLevel(Simulator *sim, uint32_t level, uint64_t address, uint32_t mode) {
+  if (level >= sim->numLevels)
+    return;
+
+  CacheLevel *Level = sim->levels[level];
+  uint32_t Line = findLine(Level, address);
+  int Swapped = 0;
+
+  if (Line != NO_LINE) {
+    touchLine(Level, Line);
+    Level->prefetched[Line] = 0;
+  }
+  else {
+    if (level == 0 && sim->config.victimEntries != 0)
+      Swapped = warmTake(&sim->victim, address);
+
+    if (!Swapped && mode == MODE_WRITE && !Level->writeAllocate) {
+      warmLevel(sim, level + 1, address, mode);
+      return;
+    }
+
+    if (!Swapped && hasInclusion(sim, level + 1, INCLUSION_EXCLUSIVE))
+      Swapped = warmTake(sim->levels[level + 1], address);
+    if (!Swapped)
+      warmLevel(sim, level + 1 + hasInclusion(sim, level + 1, INCLUSION_EXCLUSIVE), address,
+                MODE_READ);
+
+    Line = victimLine(Level, address);
+    warmRetire(sim, level, Line, address);
+    installLine(Level, Line, address);
+    Level->dirty[Line] = Swapped == 2;
+    Level->ready[Line] = 0;
+  }
+
+  if (mode == MODE_WRITE) {
+    if (Level->writeThrough)
+      warmLevel(sim, level + 1, address, MODE_WRITE);
+    else
+      Level->dirty[Line] = 1;
+  }
+}
+
+/**
+ * Function used to run the records of a trace through the hierarchy
+ * functionally, keeping the caches warm between the parts of the trace
+ * simulated in detail. Only meant for tag-only simulators of a single
+ * core, since the blocks it brings in hold no data and it does not keep
+ * the L1s of several cores coherent.
+ * Returns 0, or -1 if the simulator is not such a simulator.
+ */
+int warmTrace(Simulator *sim, const TraceRecord *records, uint64_t count) {
+  if (!sim->config.tagOnly || sim->config.cores != 1)
+    return -1;
+
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t address = records[i].address;
+    uint64_t size = records[i].size != 0 ? records[i].size : WORD_SIZE;
+    uint32_t mode = records[i].mode == MODE_READ ? MODE_READ : MODE_WRITE;
+
+    while (size > 0) {
+      uint32_t Piece = blockPiece(sim, address, size);
+
+      warmLevel(sim, 0, address, mode);
+      address += Piece;
+      size -= Piece;
+    }
+  }
+  return 0;
+}
+
+/*********************** Split transactions *************************/
+/*
+ * Requests run through the hierarchy as soon as they are issued, so a read
+ * has its data and a write is stored right away, but their timing is kept
+ * apart: each one completes when its access would, starting at the time it
+ * was issued. Requests in flight overlap, misses included, and only the
+ * MSHRs of each level limit how many misses are outstanding. The current
+ * time moves forward as completions are collected.
+ */
+
+/**
+ * Function used to issue an access of size bytes within one block at the
+ * current time, without waiting for it. *request receives its id.
+ * Returns 0 on success and -1 if there is not enough memory to track it,
+ * in which case the access is not made.
+ */
+static int issueAccess(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size,
+                       uint32_t mode, uint64_t *request) {
+  uint64_t Issued = sim->time;
+  uint64_t Done;
+
+  // Room for the completion first, the access cannot be taken back
+  if (reserveEvent(&sim->requests) != 0)
+    return -1;
+
+  accessLevel(sim, 0, address, data, size, mode);
+  Done = sim->time;
+  sim->time = Issued;
+
+  pushEvent(&sim->requests, Done, sim->nextRequest);
+  *request = sim->nextRequest++;
+  return 0;
+}
+
+/**
+ * Function used to issue a word access at the current time without
+ * waiting for it. *request receives its id, ids count up in issue order.
+ * Returns 0 on success and -1 if there is not enough memory to track it,
+ * in which case the access is not made.
+ */
+int issueRequest(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode,
+                 uint64_t *request) {
+  return issueAccess(sim, address, data, WORD_SIZE, mode, request);
+}
+
+/**
+ * Function used to wait for the first request in flight to complete,
+ * moving the current time up to its completion. *request receives its id.
+ * Returns 0 on success and -1 if no request is in flight.
+ */
+int completeRequest(Simulator *sim, uint64_t *request) {
+  Event Done;
+
+  if (popEvent(&sim->requests, &Done) != 0)
+    return -1;
+  if (Done.time > sim->time)
+    sim->time = Done.time;
+  *request = Done.id;
+  return 0;
+}
+
+uint32_t requestsInFlight(Simulator *sim) { return sim->requests.count; }
+
+/**
+ * Function used to replay a trace with up to window records in flight,
+ * issuing the next record as soon as one completes. Records that cross
+ * blocks are issued one piece at a time, each piece being a request of its
+ * own. A window of 1 times the records one after the other, like
+ * replayTrace().
+ * Returns the time spent by the whole replay. Malformed traces stop early
+ * and set the failed flag of the cursor.
+ */
+uint64_t replayWindow(Simulator *sim, TraceCursor *cursor, uint32_t window) {
+  const TraceRecord *records;
+  uint64_t Start = sim->time;
+  uint64_t request, count;
+  uint8_t bytes[UINT8_MAX];
+
+  while ((count = nextRecords(cursor, UINT64_MAX, &records)) > 0) {
+    for (uint64_t i = 0; i < count; i++) {
+      uint64_t address = records[i].address;
+      uint32_t mode = records[i].mode == MODE_READ ? MODE_READ : MODE_WRITE;
+      uint32_t size = recordData(&records[i], bytes);
+
+      for (uint32_t done = 0, piece; done < size; done += piece) {
+        piece = blockPiece(sim, address + done, size - done);
+
+        if (requestsInFlight(sim) >= window)
+          completeRequest(sim, &request);
+        // A piece that cannot be tracked was not made, and is timed in line
+        if (issueAccess(sim, address + done, &bytes[done], piece, mode, &request) != 0)
+          accessLevel(sim, 0, address + done, &bytes[done], piece, mode);
+      }
+    }
+  }
+
+  while (completeRequest(sim, &request) == 0)
+    ;
+  return sim->time - Start;
+}
+
+
+/*********************** Checkpoints *************************/
+/**
+ * Function used to append every part of a simulator to a checkpoint, in
+ * the order loadParts() reads them back.
+ * Returns 0 on success and -1 on a write error.
+ */
+static int saveParts(Simulator *sim, FILE *file) {
+  const CacheConfig *Config = &sim->config;
+
+  if (saveBytes(file, &sim->time, sizeof(sim->time)) != 0 ||
+      saveBytes(file, &sim->core, sizeof(sim->core)) != 0 ||
+      saveBytes(file, &sim->nextRequest, sizeof(sim->nextRequest)) != 0 ||
+      saveLevelStats(&sim->dramStats, file) != 0 || saveLevelStats(&sim->bufferStats, file) != 0)
+    return -1;
+
+  for (uint32_t c = 0; c < Config->cores; c++) {
+    if (saveCacheLevel(&sim->l1[c], file) != 0)
+      return -1;
+  }
+  for (uint32_t i = 1; i < sim->numLevels; i++) {
+    if (saveCacheLevel(&sim->shared[i - 1], file) != 0)
+      return -1;
+  }
+
+  if ((Config->victimEntries != 0 && saveCacheLevel(&sim->victim, file) != 0) ||
+      (Config->writeBufferEntries != 0 && saveWriteBuffer(&sim->writeBuffer, file) != 0) ||
+      saveEventQueue(&sim->requests, file) != 0 ||
+      (!Config->tagOnly && saveMemory(&sim->DRAM, file) != 0))
+    return -1;
+  return 0;
+}
+
+/**
+ * Function used to restore the parts saved by saveParts() into a simulator
+ * freshly created from the same configuration.
+ * Returns 0 on success and -1 if the checkpoint is truncated or there is
+ * not enough memory.
+ */
+static int loadParts(Simulator *sim, Snapshot *snapshot) {
+  const CacheConfig *Config = &sim->config;
+  uint32_t Core;
+
+  if (loadBytes(snapshot, &sim->time, sizeof(sim->time)) != 0 ||
+      loadBytes(snapshot, &Core, sizeof(Core)) != 0 || Core >= Config->cores ||
+      loadBytes(snapshot, &sim->nextRequest, sizeof(sim->nextRequest)) != 0 ||
+      loadLevelStats(&sim->dramStats, snapshot) != 0 ||
+      loadLevelStats(&sim->bufferStats, snapshot) != 0)
+    return -1;
+
+  for (uint32_t c = 0; c < Config->cores; c++) {
+    if (loadCacheLevel(&sim->l1[c], snapshot) != 0)
+      return -1;
+  }
+  for (uint32_t i = 1; i < sim->numLevels; i++) {
+    if (loadCacheLevel(&sim->shared[i - 1], snapshot) != 0)
+      return -1;
+  }
+
+  if ((Config->victimEntries != 0 && loadCacheLevel(&sim->victim, snapshot) != 0) ||
+      (Config->writeBufferEntries != 0 && loadWriteBuffer(&sim->writeBuffer, snapshot) != 0) ||
+      loadEventQueue(&sim->requests, snapshot) != 0 ||
+      (!Config->tagOnly && loadMemory(&sim->DRAM, snapshot) != 0))
+    return -1;
+
+  setCore(sim, Core);
+  return 0;
+}
+
+/**
+ * Function used to append the whole state of a simulator (configuration,
+ * lines and blocks of every level, replacement and prefetcher state, MSHRs,
+ * write buffer, requests in flight, DRAM contents, counters and time) to a
+ * checkpoint.
+ * Returns 0 on success and -1 on a write error.
+ */
+int saveSimulator(Simulator *sim, FILE *file) {
+  if (saveBytes(file, &sim->config, sizeof(sim->config)) != 0)
+    return -1;
+  return saveParts(sim, file);
+}
+
+/**
+ * Function used to create a simulator from the state saved by
+ * saveSimulator(), which carries on exactly where the saved one stopped.
+ * Returns NULL if the state is truncated or malformed, or there is not
+ * enough memory.
+ */
+Simulator *loadSimulator(Snapshot *snapshot) {
+  CacheConfig Config;
+  Simulator *sim;
+
+  if (loadBytes(snapshot, &Config, sizeof(Config)) != 0 ||
+      (sim = createSimulator(&Config)) == NULL)
+    return NULL;
+
+  if (loadParts(sim, snapshot) != 0) {
+    destroySimulator(sim);
+    return NULL;
+  }
+  return sim;
+}
+
+/*********************** Statistics *************************/
+/**
+ * Function used to get the counters of a level, where level numLevels is
+ * DRAM and level 0 the L1 of the current core. Returns NULL past DRAM.
+ */
+const LevelStats *getLevelStats(Simulator *sim, uint32_t level) {
+  if (level < sim->numLevels)
+    return &sim->levels[level]->stats;
+  return level == sim->numLevels ? &sim->dramStats : NULL;
+}
+
+/**
+ * Function used to get the counters of the L1 of a core.
+ */
+const LevelStats *getCoreStats(Simulator *sim, uint32_t core) {
+  return &sim->l1[core].stats;
+}
+
+uint32_t getNumLevels(Simulator *sim) { return sim->numLevels; }
+
+uint32_t getCores(Simulator *sim) { return sim->config.cores; }
+
+/**
+ * Function used to clear the counters of every level without touching the
+ * cache contents, e.g. after a warm up.
+ */
+void resetStats(Simulator *sim) {
+  for (uint32_t c = 0; c < sim->config.cores; c++)
+    resetLevelStats(&sim->l1[c].stats);
+  for (uint32_t i = 1; i < sim->numLevels; i++)
+    resetLevelStats(&sim->levels[i]->stats);
+  if (sim->config.victimEntries != 0)
+    resetLevelStats(&sim->victim.stats);
+  resetLevelStats(&sim->bufferStats);
+  resetLevelStats(&sim->dramStats);
+}
+
+/**
+ * Function used to get the counters of the victim buffer, or NULL when
+ * there is none.
+ */
+const LevelStats *getVictimStats(Simulator *sim) {
+  return sim->config.victimEntries != 0 ? &sim->victim.stats : NULL;
+}
+
+/**
+ * Function used to get the counters of the write buffer, or NULL when
+ * there is none. Hits are stores merged into a waiting entry and
+ * evictions entries drained.
+ */
+const LevelStats *getWriteBufferStats(Simulator *sim) {
+  return sim->config.writeBufferEntries != 0 ? &sim->bufferStats : NULL;
+}
+
+/**
+ * Function used to list the levels to export: every core's L1 ("L1", or
+ * "L1.<core>" with several cores), the victim buffer ("VC"), the write
+ * buffer ("WB"), the shared levels and DRAM.
+ * Returns NULL past DRAM.
+ */
+static const LevelStats *exportedLevel(Simulator *sim, uint32_t i, char *name, size_t size) {
+  uint32_t cores = sim->config.cores;
+
+  if (i < cores) {
+    if (cores > 1)
+      snprintf(name, size, "L1.%u", i);
+    else
+      snprintf(name, size, "L1");
+    return &sim->l1[i].stats;
+  }
+
+  if (sim->config.victimEntries != 0 && i-- == cores) {
+    snprintf(name, size, "VC");
+    return &sim->victim.stats;
+  }
+
+  if (sim->config.writeBufferEntries != 0 && i-- == cores) {
+    snprintf(name, size, "WB");
+    return &sim->bufferStats;
+  }
+
+  i -= cores - 1;
+  if (i < sim->numLevels)
+    snprintf(name, size, "L%u", i + 1);
+  else
+    snprintf(name, size, "DRAM");
+  return getLevelStats(sim, i);
+}
+
+/**
+ * Function used to export the counters of every level and DRAM, as CSV
+ * with a header row or as a JSON object. Can be called at any time.
+ */
+void printStats(Simulator *sim, FILE *file, int format) {
+  char name[16];
+  const LevelStats *stats;
+
+  if (format == STATS_JSON)
+    fprintf(file, "{\"time\": %llu, \"levels\": [\n", (unsigned long long)sim->time);
+  else
+    fprintf(file, "level,reads,writes,bytes_read,bytes_written,hits,misses,evictions,"
+                  "writebacks,invalidations,upgrades,transfers,prefetches,useful_prefetches,"
+                  "late_prefetches,useless_prefetches,accuracy,coverage,timeliness,merges,"
+                  "stalls\n");
+
+  for (uint32_t i = 0; (stats = exportedLevel(sim, i, name, sizeof(name))) != NULL; i++) {
+    if (format == STATS_JSON)
+      fprintf(file, "%s  ", i ? ",\n" : "");
+    printLevelStats(file, format, name, stats);
+  }
+
+  if (format == STATS_JSON)
+    fprintf(file, "\n]}\n");
+}
+
+/**
+ * Function used to export the sampled per-set hits and misses of every
+ * cache level, as CSV with a header row or as a JSON array.
+ */
+void printHeatmap(Simulator *sim, FILE *file, int format) {
+  char name[16];
+  uint32_t caches = sim->config.cores + (sim->config.victimEntries != 0) +
+                    (sim->config.writeBufferEntries != 0) + sim->numLevels - 1;
+
+  fprintf(file, format == STATS_JSON ? "[\n" : "level,set,hits,misses\n");
+  for (uint32_t i = 0; i < caches; i++) {
+    const LevelStats *stats = exportedLevel(sim, i, name, sizeof(name));
+    if (format == STATS_JSON)
+      fprintf(file, "%s  ", i ? ",\n" : "");
+    printLevelHeatmap(file, format, name, stats);
+  }
+  if (format == STATS_JSON)
+    fprintf(file, "\n]\n");
+}
@@ -0,0 +1,96 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "Config.h"
+#include "CacheLevel.h"
+#include "Stats.h"
+#include "Memory.h"
+#include "WriteBuffer.h"
+#include "Trace.h"
+
+#define BATCH_SIZE 4096 // accesses per accessBatch() call in the replayers
+
+typedef struct Simulator Simulator;
+
+/* Provided by each model (L1Cache, L2Cache, L2Cache2) */
+void modelConfig(CacheConfig *config);
+
+Simulator *createSimulator(const CacheConfig *config);
+void destroySimulator(Simulator *sim);
+
+void resetTime(Simulator *sim);
+
+uint64_t getTime(Simulator *sim);
+
+/****************  RAM memory (byte addressable) ***************/
+void accessDRAM(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode);
+
+/*********************** Cache *************************/
+
+void initCache(Simulator *sim);
+
+void accessLevel(Simulator *sim, uint32_t level, uint64_t address, uint8_t *data,
+                 uint32_t size, uint32_t mode);
+void accessL1(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode);
+void accessL2(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode);
+
+/*********************** Interfaces *************************/
+
+void read(Simulator *sim, uint64_t address, uint8_t *data);
+void write(Simulator *sim, uint64_t address, uint8_t *data);
+uint64_t accessBatch(Simulator *sim, const uint64_t *addresses, const uint8_t *modes,
+                     uint8_t *data, size_t count);
+uint64_t replayTrace(Simulator *sim, const TraceRecord *records, uint64_t count);
+uint64_t replayRecords(Simulator *sim, TraceCursor *cursor, uint64_t count);
+
+/*********************** Sized accesses *************************/
+
+void accessBytes(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size,
+                 uint32_t mode);
+void readBytes(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size);
+void writeBytes(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size);
+void copyBytes(Simulator *sim, uint64_t destination, uint64_t source, uint64_t size);
+void setBytes(Simulator *sim, uint64_t address, uint8_t value, uint64_t size);
+
+/*********************** Functional warming *************************/
+
+int warmTrace(Simulator *sim, const TraceRecord *records, uint64_t count);
+
+/*********************** Split transactions *************************/
+
+int issueRequest(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode,
+                 uint64_t *request);
+int completeRequest(Simulator *sim, uint64_t *request);
+uint32_t requestsInFlight(Simulator *sim);
+uint64_t replayWindow(Simulator *sim, TraceCursor *cursor, uint32_t window);
+
+/*********************** Multi-core *************************/
+
+void setCore(Simulator *sim, uint32_t core);
+uint32_t getCore(Simulator *sim);
+uint64_t replayInterleaved(Simulator *sim, TraceCursor *cursors, uint32_t cores);
+
+/*********************** Checkpoints *************************/
+
+int saveSimulator(Simulator *sim, FILE *file);
+Simulator *loadSimulator(Snapshot *snapshot);
+int saveCheckpoint(Simulator *sim, const char *path);
+Simulator *loadCheckpoint(const char *path);
+
+/*********************** Statistics *************************/
+
+uint32_t getNumLevels(Simulator *sim);
+uint32_t getCores(Simulator *sim);
+const LevelStats *getLevelStats(Simulator *sim, uint32_t level);
+const LevelStats *getCoreStats(Simulator *sim, uint32_t core);
+const LevelStats *getVictimStats(Simulator *sim);
+const LevelStats *getWriteBufferStats(Simulator *sim);
+void resetStats(Simulator *sim);
+void printStats(Simulator *sim, FILE *file, int format);
+void printHeatmap(Simulator *sim, FILE *file, int format);
+
+#endif
@@ -0,0 +1,315 @@
+#include <stdlib.h>
+#include <string.h>
+#include "StackDistance.h"
+
+#define NO_BLOCK UINT32_MAX
+#define EMPTY_KEY UINT64_MAX   // block addresses have at most 64 - 2 bits
+#define INITIAL_SLOTS 16
+#define INITIAL_BLOCKS 1024
+
+/*
+ * Recency order of one set. Every access takes the next slot and frees the
+ * slot of the previous access to the same block, so the live slots after
+ * a block's last slot are the distinct blocks used since then. When the
+ * slots run out the live ones are renumbered from 1 (and the tree grows if
+ * more than half of them are live).
+ */
+typedef struct SetStack {
+  uint32_t *tree;   // Fenwick tree of live slots, 1-based
+  uint32_t *block;  // block id of each slot, NO_BLOCK once freed
+  uint32_t used;
+  uint32_t live;
+  uint32_t capacity;
+} SetStack;
+
+/*
+ * Stack distances for one number of sets. last[id] is the slot of the
+ * last access to a block id in its set, 0 if it was never accessed.
+ */
+typedef struct SetsLevel {
+  SetStack *sets;
+  uint32_t *last;
+  uint64_t buckets[DISTANCE_BUCKETS];
+} SetsLevel;
+
+struct StackDistance {
+  int blockShift;
+  uint32_t numLevels;       // levels[k] has 2^k sets
+  SetsLevel *levels;
+
+  uint64_t *keys;           // block address -> dense block id, open addressing
+  uint32_t *ids;
+  uint32_t mapCapacity;
+  uint32_t blocks;
+  uint32_t blockCapacity;
+
+  uint64_t accesses;
+};
+
+static int log2i(uint32_t value) {
+  int bits = 0;
+  while (value >>= 1)
+    bits++;
+  return bits;
+}
+
+/**************** Fenwick tree ***************/
+static void treeAdd(uint32_t *tree, uint32_t capacity, uint32_t slot, int32_t delta) {
+  for (; slot <= capacity; slot += slot & -slot)
+    tree[slot] += delta;
+}
+
+static uint32_t treePrefix(const uint32_t *tree, uint32_t slot) {
+  uint32_t sum = 0;
+  for (; slot > 0; slot -= slot & -slot)
+    sum += tree[slot];
+  return sum;
+}
+
+/**
+ * Function used to renumber the live slots of a set from 1 and rebuild its
+ * tree in linear time. Returns 0 on success and -1 if there is not enough
+ * memory.
+ */
+static int compactSet(SetStack *set, uint32_t *last) {
+  uint32_t capacity = set->capacity;
+  if (capacity == 0)
+    capacity = INITIAL_SLOTS;
+  else if (set->live * 2 > capacity)
+    capacity *= 2;
+
+  uint32_t *tree = calloc((size_t)capacity + 1, sizeof(uint32_t));
+  uint32_t *block = malloc(((size_t)capacity + 1) * sizeof(uint32_t));
+  if (tree == NULL || block == NULL) {
+    free(tree);
+    free(block);
+    return -1;
+  }
+
+  uint32_t live = 0;
+  for (uint32_t slot = 1; slot <= set->used; slot++) {
+    if (set->block[slot] != NO_BLOCK) {
+      block[++live] = set->block[slot];
+      last[set->block[slot]] = live;
+      tree[live] = 1;
+    }
+  }
+
+  for (uint32_t slot = 1; slot <= capacity; slot++) {
+    uint32_t parent = slot + (slot & -slot);
+    if (parent <= capacity)
+      tree[parent] += tree[slot];
+  }
+
+  free(set->tree);
+  free(set->block);
+  set->tree = tree;
+  set->block = block;
+  set->used = live;
+  set->capacity = capacity;
+  return 0;
+}
+
+/**************** Block ids ***************/
+static uint64_t hashBlock(uint64_t block) {
+  block *= 0x9E3779B97F4A7C15ull;
+  return block ^ (block >> 32);
+}
+
+/**
+ * Function used to give every block address a dense id, growing the map
+ * and the per-level last slot arrays as needed.
+ * Returns NO_BLOCK if there is not enough memory.
+ */
+static uint32_t blockId(StackDistance *stack, uint64_t block) {
+  uint32_t mask = stack->mapCapacity - 1;
+  uint32_t i = hashBlock(block) & mask;
+
+  for (; stack->keys[i] != EMPTY_KEY; i = (i + 1) & mask) {
+    if (stack->keys[i] == block)
+      return stack->ids[i];
+  }
+
+  if (stack->blocks == stack->blockCapacity) {
+    uint32_t capacity = stack->blockCapacity * 2;
+    for (uint32_t k = 0; k < stack->numLevels; k++) {
+      uint32_t *last = realloc(stack->levels[k].last, (size_t)capacity * sizeof(uint32_t));
+      if (last == NULL)
+        return NO_BLOCK;
+      memset(&last[stack->blockCapacity], 0,
+             (size_t)(capacity - stack->blockCapacity) * sizeof(uint32_t));
+      stack->levels[k].last = last;
+    }
+    stack->blockCapacity = capacity;
+  }
+
+  stack->keys[i] = block;
+  stack->ids[i] = stack->blocks++;
+
+  // Keep the map at most half full
+  if (stack->blocks * 2 > stack->mapCapacity) {
+    uint32_t capacity = stack->mapCapacity * 2;
+    uint64_t *keys = malloc((size_t)capacity * sizeof(uint64_t));
+    uint32_t *ids = malloc((size_t)capacity * sizeof(uint32_t));
+    if (keys == NULL || ids == NULL) {
+      free(keys);
+      free(ids);
+      return NO_BLOCK;
+    }
+    memset(keys, 0xFF, (size_t)capacity * sizeof(uint64_t));
+
+    for (uint32_t j = 0; j < stack->mapCapacity; j++) {
+      if (stack->keys[j] == EMPTY_KEY)
+        continue;
+      uint32_t slot = hashBlock(stack->keys[j]) & (capacity - 1);
+      while (keys[slot] != EMPTY_KEY)
+        slot = (slot + 1) & (capacity - 1);
+      keys[slot] = stack->keys[j];
+      ids[slot] = stack->ids[j];
+    }
+
+    free(stack->keys);
+    free(stack->ids);
+    stack->keys = keys;
+    stack->ids = ids;
+    stack->mapCapacity = capacity;
+  }
+
+  return stack->blocks - 1;
+}
+
+/**************** Stack distance ***************/
+/**
+ * Function used to start an analysis for blocks of blockSize bytes and
+ * caches of 1 to maxSets sets (both powers of two).
+ * Returns NULL if there is not enough memory.
+ */
+StackDistance *createStackDistance(uint32_t blockSize, uint32_t maxSets) {
+  StackDistance *stack = calloc(1, sizeof(StackDistance));
+  if (stack == NULL)
+    return NULL;
+
+  stack->blockShift = log2i(blockSize);
+  stack->numLevels = log2i(maxSets) + 1;
+  stack->mapCapacity = INITIAL_BLOCKS * 2;
+  stack->blockCapacity = INITIAL_BLOCKS;
+  stack->levels = calloc(stack->numLevels, sizeof(SetsLevel));
+  stack->keys = malloc((size_t)stack->mapCapacity * sizeof(uint64_t));
+  stack->ids = malloc((size_t)stack->mapCapacity * sizeof(uint32_t));
+
+  if (stack->levels == NULL || stack->keys == NULL || stack->ids == NULL) {
+    destroyStackDistance(stack);
+    return NULL;
+  }
+  memset(stack->keys, 0xFF, (size_t)stack->mapCapacity * sizeof(uint64_t));
+
+  for (uint32_t k = 0; k < stack->numLevels; k++) {
+    stack->levels[k].sets = calloc((size_t)1 << k, sizeof(SetStack));
+    stack->levels[k].last = calloc(stack->blockCapacity, sizeof(uint32_t));
+    if (stack->levels[k].sets == NULL || stack->levels[k].last == NULL) {
+      destroyStackDistance(stack);
+      return NULL;
+    }
+  }
+
+  return stack;
+}
+
+/**
+ * Function used to release an analysis created with createStackDistance().
+ */
+void destroyStackDistance(StackDistance *stack) {
+  if (stack == NULL)
+    return;
+
+  for (uint32_t k = 0; stack->levels != NULL && k < stack->numLevels; k++) {
+    SetsLevel *Level = &stack->levels[k];
+    for (uint32_t s = 0; Level->sets != NULL && s < (1u << k); s++) {
+      free(Level->sets[s].tree);
+      free(Level->sets[s].block);
+    }
+    free(Level->sets);
+    free(Level->last);
+  }
+  free(stack->levels);
+  free(stack->keys);
+  free(stack->ids);
+  free(stack);
+}
+
+/**
+ * Function used to feed the next access of the stream, the same address
+ * given to accessL1().
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int recordAccess(StackDistance *stack, uint64_t address) {
+  uint64_t Block = address >> stack->blockShift;
+  uint32_t Id = blockId(stack, Block);
+
+  if (Id == NO_BLOCK)
+    return -1;
+
+  stack->accesses++;
+
+  for (uint32_t k = 0; k < stack->numLevels; k++) {
+    SetsLevel *Level = &stack->levels[k];
+    SetStack *Set = &Level->sets[Block & ((1u << k) - 1)];
+    uint32_t Last = Level->last[Id];
+
+    // First accesses are misses at every size and count in no bucket
+    if (Last != 0) {
+      uint32_t Distance = Set->live - treePrefix(Set->tree, Last);
+      uint32_t Bucket = Distance == 0 ? 0 : 32 - __builtin_clz(Distance);
+
+      Level->buckets[Bucket]++;
+      treeAdd(Set->tree, Set->capacity, Last, -1);
+      Set->block[Last] = NO_BLOCK;
+      Set->live--;
+    }
+
+    if (Set->used == Set->capacity && compactSet(Set, Level->last) != 0)
+      return -1;
+
+    Set->used++;
+    Set->live++;
+    Set->block[Set->used] = Id;
+    treeAdd(Set->tree, Set->capacity, Set->used, 1);
+    Level->last[Id] = Set->used;
+  }
+
+  return 0;
+}
+
+uint64_t stackAccesses(const StackDistance *stack) { return stack->accesses; }
+
+/**
+ * Function used to get the hits of an LRU cache of sets x ways blocks,
+ * both powers of two and sets at most the maxSets of the analysis.
+ */
+uint64_t stackHits(const StackDistance *stack, uint32_t sets, uint32_t ways) {
+  const SetsLevel *Level = &stack->levels[log2i(sets)];
+  uint64_t hits = 0;
+
+  for (int bucket = 0; bucket <= log2i(ways); bucket++)
+    hits += Level->buckets[bucket];
+  return hits;
+}
+
+/**
+ * Function used to print hits and misses of every cache of at most maxSize
+ * bytes, one "sets ways size hits misses" line each.
+ */
+void printStackDistance(const StackDistance *stack, FILE *file, uint32_t maxSize) {
+  uint32_t blockSize = 1u << stack->blockShift;
+
+  fprintf(file, "Sets Ways Size Hits Misses\n");
+  for (uint32_t k = 0; k < stack->numLevels; k++) {
+    uint32_t sets = 1u << k;
+    for (uint32_t ways = 1; (uint64_t)sets * ways * blockSize <= maxSize; ways *= 2) {
+      uint64_t hits = stackHits(stack, sets, ways);
+      fprintf(file, "%u %u %llu %llu %llu\n", sets, ways,
+              (unsigned long long)sets * ways * blockSize, (unsigned long long)hits,
+              (unsigned long long)(stack->accesses - hits));
+    }
+  }
+}
@@ -0,0 +1,31 @@
+#ifndef STACKDISTANCE_H
+#define STACKDISTANCE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define DISTANCE_BUCKETS 33  // distance 0, then one bucket per power of two
+
+typedef struct StackDistance StackDistance;
+
+/*
+ * LRU stack distance (Mattson) analysis. A single pass over a stream of
+ * block addresses gives the hits of every LRU cache whose number of sets
+ * and ways are powers of two: for 2^k sets, an access hits in a cache of
+ * W ways exactly when fewer than W other blocks of its set were used since
+ * its previous access. Those distances are counted with one Fenwick tree
+ * per set, so each access costs O(log n) per number of sets.
+ */
+
+/*********************** Interfaces *************************/
+
+StackDistance *createStackDistance(uint32_t blockSize, uint32_t maxSets);
+void destroyStackDistance(StackDistance *stack);
+
+int recordAccess(StackDistance *stack, uint64_t address);
+
+uint64_t stackAccesses(const StackDistance *stack);
+uint64_t stackHits(const StackDistance *stack, uint32_t sets, uint32_t ways);
+void printStackDistance(const StackDistance *stack, FILE *file, uint32_t maxSize);
+
+#endif
@@ -0,0 +1,71 @@
+#include "Simulator.h"
+#include "StackDistance.h"
+#include "Trace.h"
+
+int main(int argc, char **argv) {
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <trace file> [config file]\n", argv[0]);
+    return 1;
+  }
+
+  CacheConfig config;
+  modelConfig(&config);
+  if (argc > 2 && loadConfig(argv[2], &config) != 0) {
+    fprintf(stderr, "Could not load config %s\n", argv[2]);
+    return 1;
+  }
+  if (validateConfig(&config) != 0) {
+    fprintf(stderr, "Invalid cache configuration\n");
+    return 1;
+  }
+
+  Trace trace;
+  TraceCursor cursor;
+  if (openTrace(argv[1], &trace) != 0 || openTraceCursor(&trace, &cursor) != 0) {
+    fprintf(stderr, "Could not open trace %s\n", argv[1]);
+    closeTrace(&trace);
+    return 1;
+  }
+
+  // Every LRU cache from one block up to the size of DRAM
+  StackDistance *stack = createStackDistance(config.blockSize,
+                                             config.dramSize / config.blockSize);
+  if (stack == NULL) {
+    fprintf(stderr, "Not enough memory\n");
+    closeTraceCursor(&cursor);
+    closeTrace(&trace);
+    return 1;
+  }
+
+  const TraceRecord *records;
+  uint64_t count;
+  while ((count = nextRecords(&cursor, UINT64_MAX, &records)) > 0) {
+    for (uint64_t i = 0; i < count; i++) {
+      uint64_t address = records[i].address;
+
+      if (recordAccess(stack, address - address % WORD_SIZE) != 0) {
+        fprintf(stderr, "Not enough memory\n");
+        destroyStackDistance(stack);
+        closeTraceCursor(&cursor);
+        closeTrace(&trace);
+        return 1;
+      }
+    }
+  }
+  if (cursor.failed) {
+    fprintf(stderr, "Malformed trace %s\n", argv[1]);
+    destroyStackDistance(stack);
+    closeTraceCursor(&cursor);
+    closeTrace(&trace);
+    return 1;
+  }
+
+  printf("Accesses: %llu\n", (unsigned long long)stackAccesses(stack));
+  printStackDistance(stack, stdout, config.dramSize);
+
+  destroyStackDistance(stack);
+  closeTraceCursor(&cursor);
+  closeTrace(&trace);
+  return 0;
+}
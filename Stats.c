@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "Stats.h"
+
+/**
+ * Function used to set up the counters of a level of the given number of
+ * sets, with heatmaps sampled once every sample accesses (0 for none).
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int initLevelStats(LevelStats *stats, uint32_t sets, uint32_t sample) {
+  memset(stats, 0, sizeof(LevelStats));
+  stats->sets = sets;
+
+  if (sets != 0 && sample != 0) {
+    stats->setHits = calloc(sets, sizeof(uint64_t));
+    stats->setMisses = calloc(sets, sizeof(uint64_t));
+    if (stats->setHits == NULL || stats->setMisses == NULL) {
+      freeLevelStats(stats);
+      return -1;
+    }
+    stats->sample = sample;
+  }
+
+  resetLevelStats(stats);
+  return 0;
+}
+
+/**
+ * Function used to release the heatmaps of a level.
+ */
+void freeLevelStats(LevelStats *stats) {
+  free(stats->setHits);
+  free(stats->setMisses);
+  stats->setHits = NULL;
+  stats->setMisses = NULL;
+  stats->sample = 0;
+}
+
+/**
+ * Function used to set every counter and heatmap entry back to 0.
+ */
+void resetLevelStats(LevelStats *stats) {
+  stats->reads = 0;
+  stats->writes = 0;
+  stats->bytesRead = 0;
+  stats->bytesWritten = 0;
+  stats->hits = 0;
+  stats->misses = 0;
+  stats->evictions = 0;
+  stats->writebacks = 0;
+  stats->invalidations = 0;
+  stats->upgrades = 0;
+  stats->transfers = 0;
+  stats->prefetches = 0;
+  stats->usefulPrefetches = 0;
+  stats->latePrefetches = 0;
+  stats->uselessPrefetches = 0;
+  stats->merges = 0;
+  stats->stalls = 0;
+  stats->countdown = stats->sample;
+
+  if (stats->sample != 0) {
+    memset(stats->setHits, 0, (size_t)stats->sets * sizeof(uint64_t));
+    memset(stats->setMisses, 0, (size_t)stats->sets * sizeof(uint64_t));
+  }
+}
+
+static double ratio(uint64_t part, uint64_t whole) {
+  return whole != 0 ? (double)part / (double)whole : 0.0;
+}
+
+/**
+ * Function used to print the counters of a level, as a CSV row matching
+ * "level,reads,writes,bytes_read,bytes_written,hits,misses,evictions,
+ * writebacks,invalidations,upgrades,transfers,prefetches,useful_prefetches,
+ * late_prefetches,useless_prefetches,accuracy,coverage,timeliness,merges,
+ * stalls" or as a JSON object.
+ */
+void printLevelStats(FILE *file, int format, const char *name, const LevelStats *stats) {
+  const char *layout = format == STATS_JSON
+      ? "{\"level\": \"%s\", \"reads\": %llu, \"writes\": %llu, \"bytes_read\": %llu, "
+        "\"bytes_written\": %llu, \"hits\": %llu, \"misses\": %llu, \"evictions\": %llu, "
+        "\"writebacks\": %llu, \"invalidations\": %llu, \"upgrades\": %llu, "
+        "\"transfers\": %llu, \"prefetches\": %llu, \"useful_prefetches\": %llu, "
+        "\"late_prefetches\": %llu, \"useless_prefetches\": %llu, \"accuracy\": %.4f, "
+        "\"coverage\": %.4f, \"timeliness\": %.4f, \"merges\": %llu, \"stalls\": %llu}"
+      : "%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,"
+        "%.4f,%.4f,%.4f,%llu,%llu\n";
+  uint64_t useful = stats->usefulPrefetches;
+
+  fprintf(file, layout, name, (unsigned long long)stats->reads,
+          (unsigned long long)stats->writes, (unsigned long long)stats->bytesRead,
+          (unsigned long long)stats->bytesWritten, (unsigned long long)stats->hits,
+          (unsigned long long)stats->misses, (unsigned long long)stats->evictions,
+          (unsigned long long)stats->writebacks, (unsigned long long)stats->invalidations,
+          (unsigned long long)stats->upgrades, (unsigned long long)stats->transfers,
+          (unsigned long long)stats->prefetches, (unsigned long long)useful,
+          (unsigned long long)stats->latePrefetches,
+          (unsigned long long)stats->uselessPrefetches, ratio(useful, stats->prefetches),
+          ratio(useful, useful + stats->misses), ratio(useful - stats->latePrefetches, useful),
+          (unsigned long long)stats->merges, (unsigned long long)stats->stalls);
+}
+
+/**
+ * Function used to print the sampled heatmap of a level, as CSV rows
+ * matching "level,set,hits,misses" or as a JSON object with one array per
+ * counter. Prints nothing (CSV) or empty arrays (JSON) without heatmaps.
+ */
+void printLevelHeatmap(FILE *file, int format, const char *name, const LevelStats *stats) {
+  uint32_t sets = stats->sample != 0 ? stats->sets : 0;
+
+  if (format != STATS_JSON) {
+    for (uint32_t set = 0; set < sets; set++)
+      fprintf(file, "%s,%u,%llu,%llu\n", name, set, (unsigned long long)stats->setHits[set],
+              (unsigned long long)stats->setMisses[set]);
+    return;
+  }
+
+  fprintf(file, "{\"level\": \"%s\", \"sample\": %u, \"hits\": [", name, stats->sample);
+  for (uint32_t set = 0; set < sets; set++)
+    fprintf(file, "%s%llu", set ? ", " : "", (unsigned long long)stats->setHits[set]);
+  fprintf(file, "], \"misses\": [");
+  for (uint32_t set = 0; set < sets; set++)
+    fprintf(file, "%s%llu", set ? ", " : "", (unsigned long long)stats->setMisses[set]);
+  fprintf(file, "]}");
+}
+
+/**
+ * Function used to append the counters and heatmaps of a level to a
+ * checkpoint.
+ * Returns 0 on success and -1 on a write error.
+ */
+int saveLevelStats(const LevelStats *stats, FILE *file) {
+  size_t Heatmap = stats->setHits != NULL ? stats->sets * sizeof(uint64_t) : 0;
+
+  if (saveBytes(file, stats, offsetof(LevelStats, sets)) != 0 ||
+      saveBytes(file, &stats->countdown, sizeof(stats->countdown)) != 0 ||
+      saveBytes(file, stats->setHits, Heatmap) != 0 ||
+      saveBytes(file, stats->setMisses, Heatmap) != 0)
+    return -1;
+  return 0;
+}
+
+/**
+ * Function used to restore the counters and heatmaps saved by
+ * saveLevelStats() into a level of the same configuration.
+ * Returns 0 on success and -1 if the checkpoint is too short.
+ */
+int loadLevelStats(LevelStats *stats, Snapshot *snapshot) {
+  size_t Heatmap = stats->setHits != NULL ? stats->sets * sizeof(uint64_t) : 0;
+
+  if (loadBytes(snapshot, stats, offsetof(LevelStats, sets)) != 0 ||
+      loadBytes(snapshot, &stats->countdown, sizeof(stats->countdown)) != 0 ||
+      loadBytes(snapshot, stats->setHits, Heatmap) != 0 ||
+      loadBytes(snapshot, stats->setMisses, Heatmap) != 0)
+    return -1;
+  return 0;
+}
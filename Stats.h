@@ -0,0 +1,106 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "Cache.h"
+#include "Checkpoint.h"
+
+/*
+ * Build with -DCACHE_STATS=0 to compile every counter update out. The
+ * per-set heatmaps are also sampled at runtime, see stats_sample.
+ */
+#ifndef CACHE_STATS
+#define CACHE_STATS 1
+#endif
+
+#if CACHE_STATS
+#define STAT(statement) do { statement; } while (0)
+#else
+#define STAT(statement) do { } while (0)
+#endif
+
+#define STATS_CSV 0
+#define STATS_JSON 1
+
+/*
+ * Counters of one cache level, or of DRAM (which only moves blocks and has
+ * no sets). Prefetch accuracy is usefulPrefetches / prefetches, coverage
+ * usefulPrefetches / (usefulPrefetches + misses) and timeliness the share
+ * of useful prefetches that were not late. setHits and setMisses record
+ * one in every sample accesses of each set, or are NULL when sample is 0.
+ */
+typedef struct LevelStats {
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t bytesRead;
+  uint64_t bytesWritten;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;      // valid lines replaced
+  uint64_t writebacks;     // dirty lines replaced
+  uint64_t invalidations;  // lines dropped for another core's write
+  uint64_t upgrades;       // write hits on shared lines
+  uint64_t transfers;      // blocks supplied to another core's L1
+  uint64_t prefetches;     // blocks fetched by the prefetcher
+  uint64_t usefulPrefetches;   // prefetched lines hit before eviction
+  uint64_t latePrefetches;     // useful ones hit before their block arrived
+  uint64_t uselessPrefetches;  // prefetched lines evicted without a hit
+  uint64_t merges;         // misses to blocks already in flight
+  uint64_t stalls;         // accesses that waited for a full write buffer
+                           // or for a free MSHR
+
+  uint32_t sets;
+  uint32_t sample;
+  uint32_t countdown;
+  uint64_t *setHits;
+  uint64_t *setMisses;
+} LevelStats;
+
+/*********************** Statistics *************************/
+
+int initLevelStats(LevelStats *stats, uint32_t sets, uint32_t sample);
+void freeLevelStats(LevelStats *stats);
+void resetLevelStats(LevelStats *stats);
+int saveLevelStats(const LevelStats *stats, FILE *file);
+int loadLevelStats(LevelStats *stats, Snapshot *snapshot);
+
+/**
+ * Function used to count a transfer of size bytes in or out of a level.
+ */
+static inline void countTransfer(LevelStats *stats, uint32_t mode, uint32_t size) {
+  if (mode == MODE_READ) {
+    stats->reads++;
+    stats->bytesRead += size;
+  }
+  else {
+    stats->writes++;
+    stats->bytesWritten += size;
+  }
+}
+
+/**
+ * Function used to count an access to a cache level and, once every sample
+ * accesses, add it to the heatmap of its set.
+ */
+static inline void countAccess(LevelStats *stats, uint32_t set, uint32_t mode,
+                               uint32_t size, int hit) {
+  countTransfer(stats, mode, size);
+  if (hit)
+    stats->hits++;
+  else
+    stats->misses++;
+
+  if (stats->sample != 0 && --stats->countdown == 0) {
+    stats->countdown = stats->sample;
+    if (hit)
+      stats->setHits[set]++;
+    else
+      stats->setMisses[set]++;
+  }
+}
+
+void printLevelStats(FILE *file, int format, const char *name, const LevelStats *stats);
+void printLevelHeatmap(FILE *file, int format, const char *name, const LevelStats *stats);
+
+#endif
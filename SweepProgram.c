@@ -0,0 +1,208 @@
+#include "Simulator.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+/*
+ * One point of the sweep. The trace is mapped once and read by every
+ * worker through a cursor of its own, each configuration gets its own
+ * simulator.
+ */
+typedef struct SweepPoint {
+  CacheConfig config;
+  uint64_t time;
+  uint64_t misses[MAX_LEVELS];
+  uint64_t dramBytes;
+  int failed;   // 1: not enough memory, 2: malformed trace
+} SweepPoint;
+
+typedef struct Sweep {
+  const Trace *trace;
+  SweepPoint *points;
+} Sweep;
+
+static void runPoint(void *context, size_t task) {
+  Sweep *sweep = context;
+  SweepPoint *point = &sweep->points[task];
+  Simulator *sim = createSimulator(&point->config);
+  TraceCursor cursor;
+
+  if (sim == NULL || openTraceCursor(sweep->trace, &cursor) != 0) {
+    destroySimulator(sim);
+    point->failed = 1;
+    return;
+  }
+  resetTime(sim);
+  initCache(sim);
+  point->time = replayRecords(sim, &cursor, UINT64_MAX);
+  point->failed = cursor.failed ? 2 : 0;
+  closeTraceCursor(&cursor);
+
+  for (uint32_t i = 0; i < getNumLevels(sim); i++)
+    point->misses[i] = getLevelStats(sim, i)->misses;
+  const LevelStats *dram = getLevelStats(sim, getNumLevels(sim));
+  point->dramBytes = dram->bytesRead + dram->bytesWritten;
+  destroySimulator(sim);
+}
+
+/**
+ * Function used to read a sweep file: one configuration per line, given as
+ * "key=value" options separated by spaces or commas on top of modelConfig().
+ * Empty lines and lines starting with '#' are ignored.
+ * Returns the number of points, or -1 if the file can't be read or has
+ * errors.
+ */
+static long loadSweep(const char *path, SweepPoint **points) {
+  char line[1024];
+  long count = 0, capacity = 0, lineNumber = 0, result = 0;
+  FILE *file = fopen(path, "r");
+
+  *points = NULL;
+  if (file == NULL)
+    return -1;
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    lineNumber++;
+
+    char *start = line + strspn(line, " \t");
+    if (*start == '#' || *start == '\n' || *start == '\0')
+      continue;
+
+    if (count == capacity) {
+      capacity = capacity ? capacity * 2 : 64;
+      SweepPoint *grown = realloc(*points, capacity * sizeof(SweepPoint));
+      if (grown == NULL) {
+        result = -1;
+        break;
+      }
+      *points = grown;
+    }
+
+    SweepPoint *point = &(*points)[count++];
+    memset(point, 0, sizeof(SweepPoint));
+    modelConfig(&point->config);
+
+    for (char *option = strtok(start, " \t\r\n,"); option != NULL;
+         option = strtok(NULL, " \t\r\n,")) {
+      char *value = strchr(option, '=');
+      if (value != NULL)
+        *value++ = '\0';
+
+      if (value == NULL || parseConfigOption(&point->config, option, value) != 0) {
+        fprintf(stderr, "%s:%ld: invalid option\n", path, lineNumber);
+        result = -1;
+      }
+    }
+
+    if (validateConfig(&point->config) != 0) {
+      fprintf(stderr, "%s:%ld: invalid cache configuration\n", path, lineNumber);
+      result = -1;
+    }
+  }
+
+  fclose(file);
+  if (result != 0) {
+    free(*points);
+    *points = NULL;
+    return -1;
+  }
+  return count;
+}
+
+static void printCsv(const SweepPoint *points, long count, uint64_t accesses) {
+  char value[32];
+
+  printf("point");
+  for (size_t i = 0; configOptionName(i) != NULL; i++)
+    printf(",%s", configOptionName(i));
+  printf(",accesses,time");
+  for (uint32_t i = 0; i < MAX_LEVELS; i++)
+    printf(",l%u_misses", i + 1);
+  printf(",dram_bytes\n");
+
+  for (long p = 0; p < count; p++) {
+    printf("%ld", p);
+    for (size_t i = 0; configOptionName(i) != NULL; i++) {
+      formatConfigOption(&points[p].config, i, value, sizeof(value));
+      printf(",%s", value);
+    }
+    printf(",%llu,%llu", (unsigned long long)accesses, (unsigned long long)points[p].time);
+    for (uint32_t i = 0; i < MAX_LEVELS; i++)
+      printf(",%llu", (unsigned long long)points[p].misses[i]);
+    printf(",%llu\n", (unsigned long long)points[p].dramBytes);
+  }
+}
+
+static void printJson(const SweepPoint *points, long count, uint64_t accesses) {
+  char value[32];
+
+  printf("[\n");
+  for (long p = 0; p < count; p++) {
+    printf("  {\"point\": %ld", p);
+    for (size_t i = 0; configOptionName(i) != NULL; i++) {
+      formatConfigOption(&points[p].config, i, value, sizeof(value));
+      if (value[0] >= '0' && value[0] <= '9')
+        printf(", \"%s\": %s", configOptionName(i), value);
+      else
+        printf(", \"%s\": \"%s\"", configOptionName(i), value);
+    }
+    printf(", \"accesses\": %llu, \"time\": %llu", (unsigned long long)accesses,
+           (unsigned long long)points[p].time);
+    for (uint32_t i = 0; i < MAX_LEVELS; i++)
+      printf(", \"l%u_misses\": %llu", i + 1, (unsigned long long)points[p].misses[i]);
+    printf(", \"dram_bytes\": %llu}%s\n", (unsigned long long)points[p].dramBytes,
+           p + 1 < count ? "," : "");
+  }
+  printf("]\n");
+}
+
+int main(int argc, char **argv) {
+  int json = argc > 1 && strcmp(argv[1], "--json") == 0;
+
+  if (argc - json < 3) {
+    fprintf(stderr, "Usage: %s [--json] <trace file> <sweep file> [threads]\n", argv[0]);
+    return 1;
+  }
+
+  const char *tracePath = argv[1 + json], *sweepPath = argv[2 + json];
+  unsigned threads = argc - json > 3 ? (unsigned)strtoul(argv[3 + json], NULL, 0)
+                                     : hardwareThreads();
+
+  SweepPoint *points;
+  long count = loadSweep(sweepPath, &points);
+  if (count < 0) {
+    fprintf(stderr, "Could not load sweep %s\n", sweepPath);
+    return 1;
+  }
+
+  Trace trace;
+  if (openTrace(tracePath, &trace) != 0) {
+    fprintf(stderr, "Could not open trace %s\n", tracePath);
+    free(points);
+    return 1;
+  }
+
+  Sweep sweep = {&trace, points};
+  runTasks(count, threads, runPoint, &sweep);
+
+  int result = 0;
+  for (long p = 0; p < count; p++) {
+    if (points[p].failed) {
+      if (points[p].failed == 2)
+        fprintf(stderr, "Malformed trace %s at point %ld\n", tracePath, p);
+      else
+        fprintf(stderr, "Not enough memory for point %ld\n", p);
+      result = 1;
+    }
+  }
+
+  if (result == 0) {
+    if (json)
+      printJson(points, count, trace.count);
+    else
+      printCsv(points, count, trace.count);
+  }
+
+  free(points);
+  closeTrace(&trace);
+  return result;
+}
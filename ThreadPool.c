@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "ThreadPool.h"
+
+/*
+ * Tasks still owned by one worker, [head, tail). The owner takes tasks from
+ * the tail and idle workers steal from the head, so they only meet on the
+ * last task of a queue.
+ */
+typedef struct TaskQueue {
+  pthread_mutex_t lock;
+  size_t head;
+  size_t tail;
+} TaskQueue;
+
+typedef struct Pool {
+  TaskQueue *queues;
+  unsigned threads;
+  TaskFunction function;
+  void *context;
+} Pool;
+
+typedef struct Worker {
+  Pool *pool;
+  unsigned id;
+} Worker;
+
+/**
+ * Function used to take a task from the tail (own queue) or the head
+ * (stolen) of a queue. Returns 1 if a task was taken and 0 if it is empty.
+ */
+static int takeTask(TaskQueue *queue, int steal, size_t *task) {
+  int found = 0;
+
+  pthread_mutex_lock(&queue->lock);
+  if (queue->head < queue->tail) {
+    *task = steal ? queue->head++ : --queue->tail;
+    found = 1;
+  }
+  pthread_mutex_unlock(&queue->lock);
+  return found;
+}
+
+/**
+ * Function used to run tasks until every queue is empty. No task is added
+ * once the batch starts, so a worker that finds nothing to steal is done.
+ */
+static void *runWorker(void *argument) {
+  Worker *worker = argument;
+  Pool *pool = worker->pool;
+  size_t task;
+
+  for (;;) {
+    int found = takeTask(&pool->queues[worker->id], 0, &task);
+
+    for (unsigned i = 1; !found && i < pool->threads; i++)
+      found = takeTask(&pool->queues[(worker->id + i) % pool->threads], 1, &task);
+
+    if (!found)
+      return NULL;
+    pool->function(pool->context, task);
+  }
+}
+
+/**
+ * Function used to get the number of online processors.
+ */
+unsigned hardwareThreads(void) {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (unsigned)count : 1;
+}
+
+/**
+ * Function used to run function(context, 0 .. count-1) on threads workers
+ * (the calling thread is one of them) and wait for all of them. Each worker
+ * starts with a contiguous share of the tasks and steals from the others
+ * once its own share is done. If threads can't be created the remaining
+ * workers, at least the caller, run every task anyway.
+ */
+void runTasks(size_t count, unsigned threads, TaskFunction function, void *context) {
+  if (threads == 0)
+    threads = 1;
+  if (threads > count)
+    threads = count > 0 ? (unsigned)count : 1;
+
+  Pool pool = {NULL, threads, function, context};
+  pthread_t *handles = calloc(threads, sizeof(pthread_t));
+  Worker *workers = calloc(threads, sizeof(Worker));
+  int *started = calloc(threads, sizeof(int));
+  pool.queues = calloc(threads, sizeof(TaskQueue));
+
+  if (handles == NULL || workers == NULL || started == NULL || pool.queues == NULL) {
+    for (size_t task = 0; task < count; task++)
+      function(context, task);
+    free(handles);
+    free(workers);
+    free(started);
+    free(pool.queues);
+    return;
+  }
+
+  for (unsigned i = 0; i < threads; i++) {
+    pthread_mutex_init(&pool.queues[i].lock, NULL);
+    pool.queues[i].head = count * i / threads;
+    pool.queues[i].tail = count * (i + 1) / threads;
+    workers[i].pool = &pool;
+    workers[i].id = i;
+  }
+
+  for (unsigned i = 1; i < threads; i++)
+    started[i] = pthread_create(&handles[i], NULL, runWorker, &workers[i]) == 0;
+  runWorker(&workers[0]);
+
+  for (unsigned i = 1; i < threads; i++) {
+    if (started[i])
+      pthread_join(handles[i], NULL);
+  }
+
+  for (unsigned i = 0; i < threads; i++)
+    pthread_mutex_destroy(&pool.queues[i].lock);
+  free(handles);
+  free(workers);
+  free(started);
+  free(pool.queues);
+}
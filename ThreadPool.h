@@ -0,0 +1,14 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stddef.h>
+
+/* Runs task number task of a batch, context is shared by all of them */
+typedef void (*TaskFunction)(void *context, size_t task);
+
+/*********************** Interfaces *************************/
+
+unsigned hardwareThreads(void);
+void runTasks(size_t count, unsigned threads, TaskFunction function, void *context);
+
+#endif
@@ -0,0 +1,560 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Cache.h"
+#include "Trace.h"
+
+/**
+ * Function used to widen the records of a version 1 trace.
+ * Returns NULL if there is not enough memory.
+ */
+static TraceRecord *convertV1(const TraceRecordV1 *records, uint64_t count) {
+  TraceRecord *converted = calloc(count ? count : 1, sizeof(TraceRecord));
+
+  for (uint64_t i = 0; converted != NULL && i < count; i++) {
+    converted[i].address = records[i].address;
+    converted[i].mode = records[i].mode;
+    converted[i].size = records[i].size;
+  }
+  return converted;
+}
+
+/**************** Packed records ***************/
+
+/**
+ * Function used to write value, high << 64 | low with high < 4, as a
+ * varint of 7 bits per byte, least significant first.
+ * Returns the number of bytes written, at most 10.
+ */
+static size_t putVarint(uint8_t *out, uint64_t low, uint32_t high) {
+  size_t n = 0;
+
+  while (high != 0 || low >= 0x80) {
+    out[n++] = (uint8_t)(low | 0x80);
+    low = (low >> 7) | ((uint64_t)high << 57);
+    high >>= 7;
+  }
+  out[n++] = (uint8_t)low;
+  return n;
+}
+
+/**
+ * Function used to encode a record after one of address previous and
+ * size previousSize.
+ * Returns the number of bytes written, at most MAX_PACKED_RECORD.
+ */
+static size_t packRecord(uint8_t *out, const TraceRecord *record, uint64_t previous,
+                         uint8_t previousSize) {
+  uint64_t Delta = record->address - previous;
+  uint64_t Zigzag = (Delta << 1) ^ (uint64_t)((int64_t)Delta >> 63);
+  uint64_t Changed = record->size != previousSize;
+  size_t n = putVarint(out, Zigzag << 2 | Changed << 1 | (record->mode == MODE_READ),
+                       (uint32_t)(Zigzag >> 62));
+
+  if (Changed)
+    out[n++] = record->size;
+  return n;
+}
+
+/**
+ * Function used to decode the count records of a chunk.
+ * Returns 0, or -1 if the chunk is malformed.
+ */
+static int unpackRecords(const uint8_t *next, const uint8_t *end, TraceRecord *records,
+                         uint32_t count) {
+  uint64_t Address = 0;
+  uint8_t Size = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t Low = 0;
+    uint32_t High = 0;
+    int Shift = 0;
+    uint8_t Byte;
+
+    do {
+      if (next == end || Shift > 63)
+        return -1;
+      Byte = *next++;
+      Low |= (uint64_t)(Byte & 0x7F) << Shift;
+      if (Shift > 57)
+        High |= (Byte & 0x7F) >> (64 - Shift);
+      Shift += 7;
+    } while (Byte & 0x80);
+
+    uint64_t Zigzag = Low >> 2 | (uint64_t)High << 62;
+    if (Low & 2) {
+      if (next == end)
+        return -1;
+      Size = *next++;
+    }
+
+    Address += (Zigzag >> 1) ^ (0 - (Zigzag & 1));
+    memset(&records[i], 0, sizeof(TraceRecord));
+    records[i].address = Address;
+    records[i].mode = Low & 1 ? MODE_READ : MODE_WRITE;
+    records[i].size = Size;
+  }
+  return next == end ? 0 : -1;
+}
+
+
+/**************** Trace files ***************/
+
+/**
+ * Function used to map a trace file and check its header.
+ * Returns 0 on success and -1 if the file is missing or not a trace.
+ */
+static int mapTrace(const char *path, Trace *trace) {
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+
+  memset(trace, 0, sizeof(*trace));
+  if (fd < 0)
+    return -1;
+
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(TraceHeader)) {
+    close(fd);
+    return -1;
+  }
+
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return -1;
+
+  const TraceHeader *Header = map;
+  if (Header->magic != TRACE_MAGIC || Header->version < 1 ||
+      Header->version > TRACE_PACKED_VERSION) {
+    munmap(map, st.st_size);
+    return -1;
+  }
+
+  trace->count = Header->count;
+  trace->map = map;
+  trace->mapSize = st.st_size;
+  return 0;
+}
+
+/**
+ * Function used to find the index of a packed trace and check that its
+ * chunks lie between the header and the index and add up to the records
+ * of the header.
+ * Returns 0 on success and -1 if the index is malformed.
+ */
+static int readIndex(Trace *trace) {
+  const uint8_t *Bytes = trace->map;
+  size_t Size = trace->mapSize;
+  TraceFooter Footer;
+  uint64_t First = 0;
+
+  if (Size < sizeof(TraceHeader) + sizeof(TraceFooter))
+    return -1;
+  memcpy(&Footer, &Bytes[Size - sizeof(TraceFooter)], sizeof(Footer));
+
+  uint64_t Room = Size - sizeof(TraceFooter);
+  if (Footer.index < sizeof(TraceHeader) || Footer.index > Room ||
+      Footer.index % sizeof(uint64_t) != 0 ||
+      Footer.chunks != (Room - Footer.index) / sizeof(TraceChunk) ||
+      (Room - Footer.index) % sizeof(TraceChunk) != 0)
+    return -1;
+
+  trace->chunks = (const TraceChunk *)&Bytes[Footer.index];
+  trace->numChunks = Footer.chunks;
+
+  for (uint64_t i = 0; i < trace->numChunks; i++) {
+    const TraceChunk *Chunk = &trace->chunks[i];
+
+    if (Chunk->offset < sizeof(TraceHeader) || Chunk->offset > Footer.index ||
+        Chunk->bytes > Footer.index - Chunk->offset || Chunk->first != First ||
+        Chunk->count > Chunk->bytes || Chunk->count > TRACE_CHUNK_RECORDS)
+      return -1;
+    First += Chunk->count;
+  }
+  return First == trace->count ? 0 : -1;
+}
+
+/**
+ * Function used to open a trace file, mapping it into memory. The records
+ * of version 2 files are accessed straight from the page cache, so
+ * replaying a trace costs no read() calls or parsing per access. Packed
+ * files only have their index checked: records stays NULL and they are
+ * read a chunk at a time through a TraceCursor.
+ * Returns 0 on success and -1 if the file is missing or malformed.
+ */
+int openTrace(const char *path, Trace *trace) {
+  if (mapTrace(path, trace) != 0)
+    return -1;
+
+  if (((const TraceHeader *)trace->map)->version == TRACE_PACKED_VERSION) {
+    if (readIndex(trace) != 0) {
+      closeTrace(trace);
+      return -1;
+    }
+    return 0;
+  }
+
+  const TraceHeader *Header = trace->map;
+  size_t recordSize = Header->version == 1 ? sizeof(TraceRecordV1) : sizeof(TraceRecord);
+  size_t available = (trace->mapSize - sizeof(TraceHeader)) / recordSize;
+
+  if (Header->count > available) {
+    closeTrace(trace);
+    return -1;
+  }
+
+  // Records are consumed front to back, let the kernel read ahead
+  madvise(trace->map, trace->mapSize, MADV_SEQUENTIAL);
+  trace->records = (const TraceRecord *)(Header + 1);
+
+  if (Header->version == 1) {
+    trace->converted = convertV1((const TraceRecordV1 *)(Header + 1), Header->count);
+    if (trace->converted == NULL) {
+      closeTrace(trace);
+      return -1;
+    }
+    trace->records = trace->converted;
+  }
+  return 0;
+}
+
+/**
+ * Function used to open a packed trace only, e.g. to decode its chunks on
+ * demand with decodeChunk() from any record or to split it between
+ * threads.
+ * Returns 0 on success and -1 if the file is missing, not packed or
+ * malformed.
+ */
+int openTraceIndex(const char *path, Trace *trace) {
+  if (mapTrace(path, trace) != 0)
+    return -1;
+
+  if (((const TraceHeader *)trace->map)->version != TRACE_PACKED_VERSION ||
+      readIndex(trace) != 0) {
+    closeTrace(trace);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Function used to release a trace opened with openTrace() or
+ * openTraceIndex().
+ */
+void closeTrace(Trace *trace) {
+  if (trace->map != NULL)
+    munmap(trace->map, trace->mapSize);
+  free(trace->converted);
+
+  trace->records = NULL;
+  trace->count = 0;
+  trace->map = NULL;
+  trace->mapSize = 0;
+  trace->converted = NULL;
+  trace->chunks = NULL;
+  trace->numChunks = 0;
+}
+
+/**
+ * Function used to find the chunk of a packed trace holding a record.
+ * Returns the chunk, or numChunks past the last record.
+ */
+uint64_t findChunk(const Trace *trace, uint64_t record) {
+  uint64_t Low = 0, High = trace->numChunks;
+
+  if (record >= trace->count)
+    return trace->numChunks;
+
+  // Last chunk whose first record is at or before record
+  while (High - Low > 1) {
+    uint64_t Middle = Low + (High - Low) / 2;
+    if (trace->chunks[Middle].first <= record)
+      Low = Middle;
+    else
+      High = Middle;
+  }
+  return Low;
+}
+
+/**
+ * Function used to decode one chunk of a packed trace into records, which
+ * must have room for chunks[chunk].count of them.
+ * Returns the number of records decoded, or -1 if the chunk is malformed.
+ */
+int64_t decodeChunk(const Trace *trace, uint64_t chunk, TraceRecord *records) {
+  if (chunk >= trace->numChunks)
+    return -1;
+
+  const TraceChunk *Chunk = &trace->chunks[chunk];
+  const uint8_t *First = (const uint8_t *)trace->map + Chunk->offset;
+
+  if (unpackRecords(First, First + Chunk->bytes, records, Chunk->count) != 0)
+    return -1;
+  return Chunk->count;
+}
+
+
+/**************** Trace cursors ***************/
+
+/**
+ * Function used to start reading an open trace from its first record. Each
+ * cursor holds one decoded chunk of a packed trace, so several of them can
+ * read the same trace at once.
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int openTraceCursor(const Trace *trace, TraceCursor *cursor) {
+  cursor->trace = trace;
+  cursor->next = 0;
+  cursor->chunk = trace->numChunks;
+  cursor->failed = 0;
+  cursor->decoded = NULL;
+
+  if (trace->chunks != NULL &&
+      (cursor->decoded = malloc(TRACE_CHUNK_RECORDS * sizeof(TraceRecord))) == NULL)
+    return -1;
+  return 0;
+}
+
+/**
+ * Function used to release the decoded chunk of a cursor.
+ */
+void closeTraceCursor(TraceCursor *cursor) {
+  free(cursor->decoded);
+  cursor->decoded = NULL;
+}
+
+/**
+ * Function used to get the next records of a trace, up to count of them.
+ * *records points into the trace, or into the chunk decoded by the cursor
+ * for packed traces, and stays valid until the next call. Pieces of packed
+ * traces end at chunk boundaries.
+ * Returns the number of records, 0 at the end of the trace or if a chunk
+ * is malformed, which sets failed.
+ */
+uint64_t nextRecords(TraceCursor *cursor, uint64_t count, const TraceRecord **records) {
+  const Trace *Source = cursor->trace;
+  uint64_t Left = Source->count - cursor->next;
+
+  if (count > Left)
+    count = Left;
+  if (count == 0 || cursor->failed)
+    return 0;
+
+  if (Source->chunks == NULL) {
+    *records = &Source->records[cursor->next];
+    cursor->next += count;
+    return count;
+  }
+
+  uint64_t Chunk = findChunk(Source, cursor->next);
+  if (Chunk != cursor->chunk) {
+    if (decodeChunk(Source, Chunk, cursor->decoded) < 0) {
+      cursor->failed = 1;
+      return 0;
+    }
+    cursor->chunk = Chunk;
+  }
+
+  uint64_t Offset = cursor->next - Source->chunks[Chunk].first;
+  uint64_t Available = Source->chunks[Chunk].count - Offset;
+
+  if (count > Available)
+    count = Available;
+  *records = &cursor->decoded[Offset];
+  cursor->next += count;
+  return count;
+}
+
+/**
+ * Function used to store an array of records as a binary trace file.
+ * Returns 0 on success and -1 on I/O errors.
+ */
+int writeTrace(const char *path, const TraceRecord *records, uint64_t count) {
+  TraceWriter writer;
+
+  if (openTraceWriter(path, 0, &writer) != 0)
+    return -1;
+
+  if (appendRecords(&writer, records, count) != 0) {
+    closeTraceWriter(&writer);
+    return -1;
+  }
+  return closeTraceWriter(&writer);
+}
+
+/**
+ * Function used to store an array of records as a packed trace file.
+ * Returns 0 on success and -1 on I/O errors or if there is not enough
+ * memory.
+ */
+int writePackedTrace(const char *path, const TraceRecord *records, uint64_t count) {
+  TraceWriter writer;
+
+  if (openTraceWriter(path, 1, &writer) != 0)
+    return -1;
+
+  if (appendRecords(&writer, records, count) != 0) {
+    closeTraceWriter(&writer);
+    return -1;
+  }
+  return closeTraceWriter(&writer);
+}
+
+/**
+ * Function used to release the buffers of a writer and close its file.
+ * Returns 0, or -1 if the file could not be closed.
+ */
+static int releaseWriter(TraceWriter *writer) {
+  int Status = fclose(writer->file) == 0 ? 0 : -1;
+
+  free(writer->pending);
+  free(writer->encoded);
+  free(writer->index);
+  writer->file = NULL;
+  writer->pending = NULL;
+  writer->encoded = NULL;
+  writer->index = NULL;
+  return Status;
+}
+
+/**
+ * Function used to start a binary trace file whose records are not known
+ * up front, e.g. while converting another format. With packed set the
+ * records are encoded, a chunk at a time.
+ * Returns 0 on success and -1 if the file can't be created or there is not
+ * enough memory.
+ */
+int openTraceWriter(const char *path, int packed, TraceWriter *writer) {
+  TraceHeader Header = {TRACE_MAGIC, packed ? TRACE_PACKED_VERSION : TRACE_VERSION, 0};
+
+  memset(writer, 0, sizeof(*writer));
+  writer->packed = packed != 0;
+  writer->offset = sizeof(Header);
+  writer->file = fopen(path, "wb");
+  if (writer->file == NULL)
+    return -1;
+
+  if (packed) {
+    writer->pending = malloc(TRACE_CHUNK_RECORDS * sizeof(TraceRecord));
+    writer->encoded = malloc(TRACE_CHUNK_RECORDS * MAX_PACKED_RECORD);
+  }
+
+  if ((packed && (writer->pending == NULL || writer->encoded == NULL)) ||
+      fwrite(&Header, sizeof(Header), 1, writer->file) != 1) {
+    releaseWriter(writer);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Function used to encode the pending records of a packed writer as one
+ * chunk and add it to the index.
+ * Returns 0 on success and -1 on I/O errors or if there is not enough
+ * memory.
+ */
+static int flushChunk(TraceWriter *writer) {
+  uint64_t Previous = 0;
+  uint8_t PreviousSize = 0;
+  size_t Bytes = 0;
+
+  if (writer->pendingCount == 0)
+    return 0;
+
+  if (writer->numChunks == writer->capacity) {
+    uint64_t Capacity = writer->capacity ? 2 * writer->capacity : 64;
+    TraceChunk *Index = realloc(writer->index, Capacity * sizeof(TraceChunk));
+
+    if (Index == NULL)
+      return -1;
+    writer->index = Index;
+    writer->capacity = Capacity;
+  }
+
+  for (uint32_t i = 0; i < writer->pendingCount; i++) {
+    const TraceRecord *Record = &writer->pending[i];
+
+    Bytes += packRecord(&writer->encoded[Bytes], Record, Previous, PreviousSize);
+    Previous = Record->address;
+    PreviousSize = Record->size;
+  }
+
+  if (fwrite(writer->encoded, Bytes, 1, writer->file) != 1)
+    return -1;
+
+  writer->index[writer->numChunks++] = (TraceChunk){writer->offset,
+                                                    writer->count - writer->pendingCount,
+                                                    (uint32_t)Bytes, writer->pendingCount};
+  writer->offset += Bytes;
+  writer->pendingCount = 0;
+  return 0;
+}
+
+/**
+ * Function used to append records to a trace being written.
+ * Returns 0 on success and -1 on I/O errors.
+ */
+int appendRecords(TraceWriter *writer, const TraceRecord *records, uint64_t count) {
+  if (!writer->packed) {
+    if (count != 0 && fwrite(records, sizeof(TraceRecord), count, writer->file) != count)
+      return -1;
+    writer->count += count;
+    return 0;
+  }
+
+  while (count > 0) {
+    uint32_t Room = TRACE_CHUNK_RECORDS - writer->pendingCount;
+    uint32_t n = count < Room ? (uint32_t)count : Room;
+
+    memcpy(&writer->pending[writer->pendingCount], records, n * sizeof(TraceRecord));
+    writer->pendingCount += n;
+    writer->count += n;
+    records += n;
+    count -= n;
+
+    if (writer->pendingCount == TRACE_CHUNK_RECORDS && flushChunk(writer) != 0)
+      return -1;
+  }
+  return 0;
+}
+
+/**
+ * Function used to finish a trace being written, storing its count in the
+ * header, after the last chunk, the index and the footer of packed ones.
+ * Returns 0 on success and -1 on I/O errors.
+ */
+int closeTraceWriter(TraceWriter *writer) {
+  TraceHeader Header = {TRACE_MAGIC, writer->packed ? TRACE_PACKED_VERSION : TRACE_VERSION,
+                        writer->count};
+  int Status = 0;
+
+  if (writer->packed) {
+    static const uint8_t Padding[sizeof(uint64_t)] = {0};
+    size_t Pad = 0;
+
+    // The index starts 8-byte aligned, so it is read in place
+    if (flushChunk(writer) != 0)
+      Status = -1;
+    Pad = (sizeof(uint64_t) - writer->offset % sizeof(uint64_t)) % sizeof(uint64_t);
+    if (Pad != 0 && fwrite(Padding, Pad, 1, writer->file) != 1)
+      Status = -1;
+
+    TraceFooter Footer = {writer->offset + Pad, writer->numChunks};
+    if (Status != 0 ||
+        (writer->numChunks != 0 &&
+         fwrite(writer->index, sizeof(TraceChunk), writer->numChunks, writer->file) !=
+           writer->numChunks) ||
+        fwrite(&Footer, sizeof(Footer), 1, writer->file) != 1)
+      Status = -1;
+  }
+
+  if (fseek(writer->file, 0, SEEK_SET) != 0 ||
+      fwrite(&Header, sizeof(Header), 1, writer->file) != 1)
+    Status = -1;
+  if (releaseWriter(writer) != 0)
+    Status = -1;
+  return Status;
+}
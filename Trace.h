@@ -0,0 +1,128 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Binary trace file layout:
+ *   TraceHeader  (16 bytes)
+ *   TraceRecord  (16 bytes) x count
+ * All fields are stored in host byte order. Version 1 files, with 8-byte
+ * records and 32-bit addresses, are still read.
+ *
+ * Packed trace file layout (version 3):
+ *   TraceHeader  (16 bytes)
+ *   chunks of up to TRACE_CHUNK_RECORDS encoded records
+ *   TraceChunk   (24 bytes) x chunks, the index
+ *   TraceFooter  (16 bytes)
+ * Each record is a varint (LEB128) of zigzag(address delta) << 2 | size
+ * changed << 1 | read, followed by its size in one byte if it differs from
+ * the previous one. Deltas and sizes restart from 0 at every chunk, so
+ * chunks decode independently, e.g. in parallel or from the middle.
+ */
+#define TRACE_MAGIC 0x43525443 // "CTRC"
+#define TRACE_VERSION 2
+#define TRACE_PACKED_VERSION 3
+#define TRACE_CHUNK_RECORDS 65536
+#define MAX_PACKED_RECORD 11   // 10-byte varint of up to 66 bits, then a size
+
+typedef struct TraceHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t count;
+} TraceHeader;
+
+typedef struct TraceRecord {
+  uint64_t address;
+  uint8_t mode;       // MODE_READ or MODE_WRITE
+  uint8_t size;       // in bytes
+  uint8_t reserved[6];
+} TraceRecord;
+
+typedef struct TraceChunk {
+  uint64_t offset;    // in the file
+  uint64_t first;     // index of its first record in the trace
+  uint32_t bytes;
+  uint32_t count;
+} TraceChunk;
+
+typedef struct TraceFooter {
+  uint64_t index;     // offset of the first TraceChunk
+  uint64_t chunks;
+} TraceFooter;
+
+typedef struct TraceRecordV1 {
+  uint32_t address;
+  uint8_t mode;
+  uint8_t size;
+  uint16_t reserved;
+} TraceRecordV1;
+
+/*
+ * An open trace. Version 2 records are read straight from the mapping,
+ * version 1 files are converted once into converted. Packed files keep
+ * records NULL and only their index, chunks, for decodeChunk().
+ */
+typedef struct Trace {
+  const TraceRecord *records;
+  uint64_t count;
+  void *map;
+  size_t mapSize;
+  TraceRecord *converted;
+  const TraceChunk *chunks;
+  uint64_t numChunks;
+} Trace;
+
+/*
+ * Position in an open trace read a piece at a time, whatever its version:
+ * records are handed out straight from the trace, or from the last chunk
+ * decoded for packed traces.
+ */
+typedef struct TraceCursor {
+  const Trace *trace;
+  uint64_t next;          // first record of the next piece
+  uint64_t chunk;         // held in decoded, numChunks if none
+  TraceRecord *decoded;   // TRACE_CHUNK_RECORDS records, packed traces only
+  int failed;             // a chunk was malformed
+} TraceCursor;
+
+/*
+ * A trace file being written a chunk of records at a time. The header
+ * only gets its count once the writer is closed. Packed writers hold the
+ * records of the current chunk and the index until then.
+ */
+typedef struct TraceWriter {
+  FILE *file;
+  uint64_t count;
+  int packed;
+  uint64_t offset;        // where the next chunk goes
+  TraceRecord *pending;   // TRACE_CHUNK_RECORDS records
+  uint32_t pendingCount;
+  uint8_t *encoded;       // one chunk, encoded
+  TraceChunk *index;
+  uint64_t numChunks;
+  uint64_t capacity;
+} TraceWriter;
+
+/*********************** Interfaces *************************/
+
+int openTrace(const char *path, Trace *trace);
+int openTraceIndex(const char *path, Trace *trace);
+void closeTrace(Trace *trace);
+uint64_t findChunk(const Trace *trace, uint64_t record);
+int64_t decodeChunk(const Trace *trace, uint64_t chunk, TraceRecord *records);
+
+int openTraceCursor(const Trace *trace, TraceCursor *cursor);
+void closeTraceCursor(TraceCursor *cursor);
+uint64_t nextRecords(TraceCursor *cursor, uint64_t count, const TraceRecord **records);
+
+int writeTrace(const char *path, const TraceRecord *records, uint64_t count);
+int writePackedTrace(const char *path, const TraceRecord *records, uint64_t count);
+
+int openTraceWriter(const char *path, int packed, TraceWriter *writer);
+int appendRecords(TraceWriter *writer, const TraceRecord *records, uint64_t count);
+int closeTraceWriter(TraceWriter *writer);
+
+#endif
@@ -0,0 +1,419 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Cache.h"
+#include "TraceImport.h"
+
+#define IMPORT_BUFFER 65536        // bytes of input held at once
+#define IMPORT_CHUNK 4096          // records converted per write
+#define MAX_COMMAND 4352           // decompressor command line, quoted path included
+#define CHAMPSIM_RECORD_SIZE 64
+#define CHAMPSIM_DESTINATIONS 2    // stores per instruction
+#define CHAMPSIM_SOURCES 4         // loads per instruction
+#define MAX_PENDING (1 + CHAMPSIM_DESTINATIONS + CHAMPSIM_SOURCES)
+
+static const char *FormatNames[NUM_IMPORT_FORMATS] = {"auto", "din", "lackey", "champsim"};
+
+/*
+ * The input is read into buffer, [start, end) being the bytes not parsed
+ * yet. One line or instruction of input can give several records, which
+ * wait in pending until they are returned.
+ */
+struct TraceReader {
+  FILE *file;
+  int piped;               // file is the output of a decompressor
+  uint32_t format;
+  int instructions;
+  int eof;
+  size_t start;
+  size_t end;
+  uint32_t pendingCount;
+  uint32_t pendingNext;
+  TraceRecord pending[MAX_PENDING];
+  uint8_t buffer[IMPORT_BUFFER + 1];   // room for the NUL after a last line
+};
+
+/**
+ * Function used to move the unparsed bytes to the front of the buffer and
+ * read more input after them.
+ * Returns the number of bytes read, 0 at the end of the input.
+ */
+static size_t fillBuffer(TraceReader *reader) {
+  size_t Left = reader->end - reader->start;
+  size_t Read;
+
+  memmove(reader->buffer, &reader->buffer[reader->start], Left);
+  reader->start = 0;
+  reader->end = Left;
+
+  Read = fread(&reader->buffer[Left], 1, IMPORT_BUFFER - Left, reader->file);
+  reader->end += Read;
+  if (Read == 0)
+    reader->eof = 1;
+  return Read;
+}
+
+/**
+ * Function used to get the next line of text input, NUL terminated in
+ * place.
+ * Returns the line, or NULL at the end of the input or for a line longer
+ * than the buffer.
+ */
+static char *nextLine(TraceReader *reader) {
+  for (;;) {
+    uint8_t *First = &reader->buffer[reader->start];
+    uint8_t *Newline = memchr(First, '\n', reader->end - reader->start);
+
+    if (Newline != NULL) {
+      *Newline = '\0';
+      reader->start = Newline + 1 - reader->buffer;
+      return (char *)First;
+    }
+
+    if (reader->eof || (reader->end - reader->start == IMPORT_BUFFER && reader->start == 0)) {
+      if (!reader->eof || reader->start == reader->end)
+        return NULL;
+      // Last line without a newline
+      reader->buffer[reader->end] = '\0';
+      reader->start = reader->end;
+      return (char *)First;
+    }
+    fillBuffer(reader);
+  }
+}
+
+/**
+ * Function used to get the next size bytes of binary input.
+ * Returns them, or NULL at the end of the input or if it stops short.
+ */
+static const uint8_t *nextBytes(TraceReader *reader, size_t size) {
+  while (reader->end - reader->start < size && !reader->eof)
+    fillBuffer(reader);
+
+  if (reader->end - reader->start < size)
+    return NULL;
+
+  const uint8_t *Bytes = &reader->buffer[reader->start];
+  reader->start += size;
+  return Bytes;
+}
+
+static void pushRecord(TraceReader *reader, uint64_t address, uint32_t mode, uint32_t size) {
+  TraceRecord *Record = &reader->pending[reader->pendingCount++];
+
+  memset(Record, 0, sizeof(*Record));
+  Record->address = address;
+  Record->mode = mode;
+  Record->size = size;
+}
+
+/**
+ * Function used to parse a Dinero IV din line: a label (0 read, 1 write,
+ * 2 instruction fetch, 3 and 4 escapes, ignored) and a hex address.
+ * Returns 0, or -1 if the line is malformed.
+ */
+static int parseDin(TraceReader *reader, const char *line) {
+  char *End;
+
+  while (isspace((unsigned char)*line))
+    line++;
+  if (*line == '\0')
+    return 0;    // blank line
+
+  unsigned long Label = strtoul(line, &End, 10);
+  if (End == line || !isspace((unsigned char)*End) || Label > 4)
+    return -1;
+  line = End;
+  uint64_t Address = strtoull(line, &End, 16);
+  if (End == line)
+    return -1;
+
+  if (Label == 0 || (Label == 2 && reader->instructions))
+    pushRecord(reader, Address, MODE_READ, 0);
+  else if (Label == 1)
+    pushRecord(reader, Address, MODE_WRITE, 0);
+  return 0;
+}
+
+/**
+ * Function used to parse a lackey line: "I  address,size" for instruction
+ * fetches, " L", " S" or " M" (a load then a store) for data accesses.
+ * Valgrind's own "==pid==" lines are skipped.
+ * Returns 0, or -1 if the line is malformed.
+ */
+static int parseLackey(TraceReader *reader, const char *line) {
+  char *End;
+
+  if (line[0] == '=')
+    return 0;
+  while (isspace((unsigned char)*line))
+    line++;
+  if (*line == '\0')
+    return 0;
+
+  char Kind = *line++;
+  uint64_t Address = strtoull(line, &End, 16);
+  if (End == line || *End != ',')
+    return -1;
+  line = End + 1;
+  unsigned long Size = strtoul(line, &End, 10);
+  if (End == line || Size > UINT8_MAX)
+    return -1;
+
+  switch (Kind) {
+  case 'I':
+    if (reader->instructions)
+      pushRecord(reader, Address, MODE_READ, Size);
+    return 0;
+  case 'L':
+    pushRecord(reader, Address, MODE_READ, Size);
+    return 0;
+  case 'S':
+    pushRecord(reader, Address, MODE_WRITE, Size);
+    return 0;
+  case 'M':
+    pushRecord(reader, Address, MODE_READ, Size);
+    pushRecord(reader, Address, MODE_WRITE, Size);
+    return 0;
+  }
+  return -1;
+}
+
+/**
+ * Function used to turn a ChampSim input_instr into records: the fetch of
+ * its ip, then its loads (source_memory) and stores (destination_memory),
+ * where address 0 marks an unused slot.
+ */
+static void parseChampSim(TraceReader *reader, const uint8_t *instruction) {
+  uint64_t Address;
+
+  memcpy(&Address, instruction, sizeof(Address));
+  if (reader->instructions)
+    pushRecord(reader, Address, MODE_READ, 0);
+
+  for (uint32_t i = 0; i < CHAMPSIM_SOURCES; i++) {
+    memcpy(&Address, &instruction[32 + 8 * i], sizeof(Address));
+    if (Address != 0)
+      pushRecord(reader, Address, MODE_READ, 0);
+  }
+  for (uint32_t i = 0; i < CHAMPSIM_DESTINATIONS; i++) {
+    memcpy(&Address, &instruction[16 + 8 * i], sizeof(Address));
+    if (Address != 0)
+      pushRecord(reader, Address, MODE_WRITE, 0);
+  }
+}
+
+/**
+ * Function used to guess the format of the input from its first bytes:
+ * text whose first line looks like lackey or din output, or else ChampSim
+ * binary records.
+ */
+static uint32_t guessFormat(TraceReader *reader) {
+  const uint8_t *Bytes = &reader->buffer[reader->start];
+  size_t Size = reader->end - reader->start;
+  size_t i = 0;
+
+  for (size_t k = 0; k < Size; k++) {
+    if (!isprint(Bytes[k]) && !isspace(Bytes[k]))
+      return IMPORT_CHAMPSIM;
+  }
+
+  // Skip valgrind's banner, then look at the first access
+  while (i < Size && Bytes[i] == '=') {
+    while (i < Size && Bytes[i] != '\n')
+      i++;
+    i++;
+  }
+  if (i + 2 < Size && ((Bytes[i] == 'I' && Bytes[i + 1] == ' ') ||
+                       (Bytes[i] == ' ' && strchr("LSM", Bytes[i + 1]) != NULL &&
+                        Bytes[i + 2] == ' ')))
+    return IMPORT_LACKEY;
+  return IMPORT_DIN;
+}
+
+/**
+ * Function used to open the input, through gzip or xz when it starts with
+ * their magic bytes.
+ * Returns 0 on success and -1 if it can't be read.
+ */
+static int openInput(TraceReader *reader, const char *path) {
+  static const uint8_t Gzip[] = {0x1F, 0x8B};
+  static const uint8_t Xz[] = {0xFD, '7', 'z', 'X', 'Z', 0x00};
+  uint8_t Magic[sizeof(Xz)] = {0};
+  const char *Tool = NULL;
+  FILE *file = fopen(path, "rb");
+
+  if (file == NULL)
+    return -1;
+
+  size_t Read = fread(Magic, 1, sizeof(Magic), file);
+  if (Read >= sizeof(Gzip) && memcmp(Magic, Gzip, sizeof(Gzip)) == 0)
+    Tool = "gzip";
+  else if (Read == sizeof(Xz) && memcmp(Magic, Xz, sizeof(Xz)) == 0)
+    Tool = "xz";
+
+  if (Tool == NULL) {
+    if (fseek(file, 0, SEEK_SET) != 0) {
+      fclose(file);
+      return -1;
+    }
+    reader->file = file;
+    return 0;
+  }
+  fclose(file);
+
+  // The path is single quoted for the shell, its own quotes as '\''
+  char Command[MAX_COMMAND];
+  size_t Length = (size_t)snprintf(Command, sizeof(Command), "%s -dc -- '", Tool);
+  for (const char *c = path; *c != '\0'; c++) {
+    if (Length + 6 > sizeof(Command))
+      return -1;
+    if (*c == '\'') {
+      memcpy(&Command[Length], "'\\''", 4);
+      Length += 4;
+    }
+    else {
+      Command[Length++] = *c;
+    }
+  }
+  memcpy(&Command[Length], "'", 2);
+
+  reader->file = popen(Command, "r");
+  reader->piped = 1;
+  return reader->file != NULL ? 0 : -1;
+}
+
+/**
+ * Function used to open a trace in one of the IMPORT_* formats, compressed
+ * or not. IMPORT_AUTO guesses the format.
+ * Returns NULL if the file can't be read, or there is not enough memory.
+ */
+TraceReader *openTraceReader(const char *path, uint32_t format, int instructions) {
+  if (format >= NUM_IMPORT_FORMATS)
+    return NULL;
+
+  TraceReader *reader = calloc(1, sizeof(TraceReader));
+  if (reader == NULL)
+    return NULL;
+
+  reader->format = format;
+  reader->instructions = instructions != 0;
+  if (openInput(reader, path) != 0) {
+    free(reader);
+    return NULL;
+  }
+
+  if (reader->format == IMPORT_AUTO) {
+    fillBuffer(reader);
+    reader->format = guessFormat(reader);
+  }
+  return reader;
+}
+
+/**
+ * Function used to close a reader opened with openTraceReader().
+ * Returns 0, or -1 if the decompressor failed, i.e. the input was cut
+ * short.
+ */
+int closeTraceReader(TraceReader *reader) {
+  int Status = 0;
+
+  if (reader == NULL)
+    return 0;
+
+  if (reader->piped)
+    Status = pclose(reader->file) == 0 ? 0 : -1;
+  else
+    fclose(reader->file);
+  free(reader);
+  return Status;
+}
+
+/**
+ * Function used to read up to count records.
+ * Returns the number of records read, 0 at the end of the trace, or -1 if
+ * the input is malformed.
+ */
+int64_t readRecords(TraceReader *reader, TraceRecord *records, uint32_t count) {
+  uint32_t n = 0;
+
+  while (n < count) {
+    if (reader->pendingNext < reader->pendingCount) {
+      records[n++] = reader->pending[reader->pendingNext++];
+      continue;
+    }
+    reader->pendingCount = 0;
+    reader->pendingNext = 0;
+
+    if (reader->format == IMPORT_CHAMPSIM) {
+      const uint8_t *Instruction = nextBytes(reader, CHAMPSIM_RECORD_SIZE);
+      if (Instruction == NULL)
+        return reader->start != reader->end ? -1 : (int64_t)n;
+      parseChampSim(reader, Instruction);
+      continue;
+    }
+
+    char *Line = nextLine(reader);
+    if (Line == NULL)
+      return reader->start != reader->end ? -1 : (int64_t)n;
+    if ((reader->format == IMPORT_DIN ? parseDin(reader, Line) : parseLackey(reader, Line)) != 0)
+      return -1;
+  }
+  return n;
+}
+
+/**
+ * Function used to convert a trace in one of the IMPORT_* formats into a
+ * binary trace file, packed or not, one chunk of records at a time.
+ * Returns 0 on success, -1 if the input can't be read or is malformed and
+ * -2 if the output can't be written.
+ */
+int importTrace(const char *input, uint32_t format, int instructions, const char *output,
+                int packed, uint64_t *count) {
+  TraceRecord Chunk[IMPORT_CHUNK];
+  TraceWriter Writer;
+  int64_t Read;
+  int Status = 0;
+
+  TraceReader *reader = openTraceReader(input, format, instructions);
+  if (reader == NULL)
+    return -1;
+  if (openTraceWriter(output, packed, &Writer) != 0) {
+    closeTraceReader(reader);
+    return -2;
+  }
+
+  while (Status == 0 && (Read = readRecords(reader, Chunk, IMPORT_CHUNK)) != 0) {
+    if (Read < 0)
+      Status = -1;
+    else if (appendRecords(&Writer, Chunk, (uint64_t)Read) != 0)
+      Status = -2;
+  }
+
+  *count = Writer.count;
+  if (closeTraceReader(reader) != 0 && Status == 0)
+    Status = -1;
+  if (closeTraceWriter(&Writer) != 0 && Status == 0)
+    Status = -2;
+  return Status;
+}
+
+/**
+ * Function used to get the IMPORT_* value of a format name.
+ * Returns -1 for unknown names.
+ */
+int parseImportFormat(const char *name) {
+  for (int i = 0; i < NUM_IMPORT_FORMATS; i++) {
+    if (strcmp(FormatNames[i], name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+/**
+ * Function used to get the name of an IMPORT_* value.
+ */
+const char *importFormatName(uint32_t format) {
+  return format < NUM_IMPORT_FORMATS ? FormatNames[format] : "unknown";
+}
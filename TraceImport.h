@@ -0,0 +1,37 @@
+#ifndef TRACEIMPORT_H
+#define TRACEIMPORT_H
+
+#include <stdint.h>
+#include "Trace.h"
+
+#define IMPORT_AUTO 0       // guessed from the first bytes of the input
+#define IMPORT_DIN 1        // Dinero IV: "label address" per line
+#define IMPORT_LACKEY 2     // valgrind --tool=lackey --trace-mem=yes
+#define IMPORT_CHAMPSIM 3   // ChampSim input_instr, 64 bytes per instruction
+#define NUM_IMPORT_FORMATS 4
+
+typedef struct TraceReader TraceReader;
+
+/*
+ * Streaming readers for the trace formats of other tools, turning them
+ * into TraceRecords a chunk at a time so that traces of any length are
+ * converted in constant memory. gzip and xz input is recognised by its
+ * magic bytes and read through the gzip or xz command. Instruction fetches
+ * are dropped unless asked for, since the hierarchy only models data
+ * accesses; kept, they become reads. Sizes the format doesn't give are 0,
+ * i.e. a word.
+ */
+
+/*********************** Interfaces *************************/
+
+TraceReader *openTraceReader(const char *path, uint32_t format, int instructions);
+int closeTraceReader(TraceReader *reader);
+int64_t readRecords(TraceReader *reader, TraceRecord *records, uint32_t count);
+
+int importTrace(const char *input, uint32_t format, int instructions, const char *output,
+                int packed, uint64_t *count);
+
+int parseImportFormat(const char *name);
+const char *importFormatName(uint32_t format);
+
+#endif
@@ -0,0 +1,180 @@
+#include "Simulator.h"
+#include "Trace.h"
+#include "Sampling.h"
+
+/**
+ * Function used to read the format of a --stats= or --heatmap= option.
+ * Returns STATS_CSV, STATS_JSON or -1 for anything else.
+ */
+static int parseFormat(const char *format) {
+  if (strcmp(format, "csv") == 0)
+    return STATS_CSV;
+  if (strcmp(format, "json") == 0)
+    return STATS_JSON;
+  return -1;
+}
+
+int main(int argc, char **argv) {
+  int stats = -1, heatmap = -1;
+  uint32_t window = 0;
+  const char *checkpoint = NULL, *restore = NULL;
+  SampleConfig sample = {0, 0, 0};
+  unsigned long long interval, warmup, measured;
+  const char *program = argv[0];
+
+  // Options come before the trace file
+  for (; argc > 1 && strncmp(argv[1], "--", 2) == 0; argc--, argv++) {
+    if (strncmp(argv[1], "--stats=", 8) == 0 && (stats = parseFormat(argv[1] + 8)) >= 0)
+      continue;
+    if (strncmp(argv[1], "--heatmap=", 10) == 0 && (heatmap = parseFormat(argv[1] + 10)) >= 0)
+      continue;
+    if (sscanf(argv[1], "--window=%u", &window) == 1 && window > 0)
+      continue;
+    if (sscanf(argv[1], "--sample=%llu,%llu,%llu", &interval, &warmup, &measured) == 3 &&
+        measured > 0 && interval >= warmup + measured) {
+      sample = (SampleConfig){interval, warmup, measured};
+      continue;
+    }
+    if (strncmp(argv[1], "--checkpoint=", 13) == 0 && argv[1][13] != '\0') {
+      checkpoint = argv[1] + 13;
+      continue;
+    }
+    if (strncmp(argv[1], "--restore=", 10) == 0 && argv[1][10] != '\0') {
+      restore = argv[1] + 10;
+      continue;
+    }
+    argc = 0;
+    break;
+  }
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s [--stats=csv|json] [--heatmap=csv|json] [--window=N] "
+                    "[--sample=PERIOD,WARMUP,WINDOW] [--checkpoint=FILE] [--restore=FILE] "
+                    "<trace file>[,...] [config file]\n", program);
+    return 1;
+  }
+
+  // One trace per core, separated by commas
+  char *paths[MAX_CORES];
+  uint32_t cores = 0;
+  for (char *path = strtok(argv[1], ","); path != NULL; path = strtok(NULL, ",")) {
+    if (cores == MAX_CORES) {
+      fprintf(stderr, "At most %d traces\n", MAX_CORES);
+      return 1;
+    }
+    paths[cores++] = path;
+  }
+  if ((window > 0 || sample.window > 0) && cores > 1) {
+    fprintf(stderr, "--window and --sample take a single trace\n");
+    return 1;
+  }
+  if (window > 0 && sample.window > 0) {
+    fprintf(stderr, "--window and --sample can't be combined\n");
+    return 1;
+  }
+  if (restore != NULL && argc > 2) {
+    fprintf(stderr, "--restore takes the configuration of the checkpoint\n");
+    return 1;
+  }
+
+  CacheConfig config;
+  modelConfig(&config);
+  if (argc > 2 && loadConfig(argv[2], &config) != 0) {
+    fprintf(stderr, "Could not load config %s\n", argv[2]);
+    return 1;
+  }
+  config.cores = cores;
+  // Sampled runs warm the caches functionally, which tracks no data
+  if (sample.window > 0)
+    config.tagOnly = 1;
+
+  // Packed traces are decoded a chunk at a time as they are replayed
+  Trace traces[MAX_CORES];
+  TraceCursor cursors[MAX_CORES];
+  uint64_t accesses = 0;
+  for (uint32_t c = 0; c < cores; c++) {
+    if (openTrace(paths[c], &traces[c]) != 0 || openTraceCursor(&traces[c], &cursors[c]) != 0) {
+      fprintf(stderr, "Could not open trace %s\n", paths[c]);
+      closeTrace(&traces[c]);
+      while (c-- > 0) {
+        closeTraceCursor(&cursors[c]);
+        closeTrace(&traces[c]);
+      }
+      return 1;
+    }
+    accesses += traces[c].count;
+  }
+
+  // A restored simulator starts warm, exactly where the checkpoint was taken
+  Simulator *sim = restore != NULL ? loadCheckpoint(restore) : createSimulator(&config);
+  if (sim == NULL || (restore != NULL && getCores(sim) != cores)) {
+    if (restore != NULL)
+      fprintf(stderr, "Could not restore %s for %u traces\n", restore, cores);
+    else
+      fprintf(stderr, "Invalid cache configuration\n");
+    destroySimulator(sim);
+    for (uint32_t c = 0; c < cores; c++) {
+      closeTraceCursor(&cursors[c]);
+      closeTrace(&traces[c]);
+    }
+    return 1;
+  }
+  if (restore == NULL) {
+    resetTime(sim);
+    initCache(sim);
+  }
+
+  // Replay every record without any output, with up to window records in
+  // flight if asked to, or only sample it
+  SampleResult sampled;
+  uint64_t time = 0;
+  int status = 0;
+  if (sample.window > 0) {
+    if (sampleTrace(sim, &cursors[0], &sample, &sampled) != 0) {
+      if (!cursors[0].failed)
+        fprintf(stderr, "Sampling needs a tag-only simulator\n");
+      status = 1;
+    }
+    time = (uint64_t)(sampled.cycles.mean + 0.5);
+  }
+  else if (window > 0)
+    time = replayWindow(sim, &cursors[0], window);
+  else
+    time = replayInterleaved(sim, cursors, cores);
+
+  for (uint32_t c = 0; c < cores; c++) {
+    if (cursors[c].failed) {
+      fprintf(stderr, "Malformed trace %s\n", paths[c]);
+      status = 1;
+    }
+  }
+  if (status != 0) {
+    destroySimulator(sim);
+    for (uint32_t c = 0; c < cores; c++) {
+      closeTraceCursor(&cursors[c]);
+      closeTrace(&traces[c]);
+    }
+    return 1;
+  }
+
+  printf("Accesses: %llu; Time: %llu\n", (unsigned long long)accesses,
+         (unsigned long long)time);
+  if (sample.window > 0)
+    printSampleResult(&sampled, stdout);
+  if (stats >= 0)
+    printStats(sim, stdout, stats);
+  if (heatmap >= 0)
+    printHeatmap(sim, stdout, heatmap);
+
+  if (checkpoint != NULL && saveCheckpoint(sim, checkpoint) != 0) {
+    fprintf(stderr, "Could not save checkpoint %s\n", checkpoint);
+    status = 1;
+  }
+
+  destroySimulator(sim);
+  for (uint32_t c = 0; c < cores; c++) {
+    closeTraceCursor(&cursors[c]);
+    closeTrace(&traces[c]);
+  }
+  return status;
+}
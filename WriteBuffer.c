@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <string.h>
+#include "WriteBuffer.h"
+
+/**
+ * Function used to allocate an empty write buffer of the given number of
+ * entries, each holding one block.
+ * Returns 0 on success and -1 if there is not enough memory.
+ */
+int initWriteBuffer(WriteBuffer *buffer, uint32_t entries, uint32_t blockSize) {
+  buffer->entries = entries;
+  buffer->blockSize = blockSize;
+  buffer->blocks = calloc(entries, sizeof(uint64_t));
+  buffer->arrival = calloc(entries, sizeof(uint64_t));
+  buffer->data = calloc(entries, blockSize);
+  buffer->mask = calloc(entries, blockSize);
+
+  if (buffer->blocks == NULL || buffer->arrival == NULL || buffer->data == NULL ||
+      buffer->mask == NULL) {
+    freeWriteBuffer(buffer);
+    return -1;
+  }
+
+  resetWriteBuffer(buffer);
+  return 0;
+}
+
+/**
+ * Function used to release the arrays of a write buffer.
+ */
+void freeWriteBuffer(WriteBuffer *buffer) {
+  free(buffer->blocks);
+  free(buffer->arrival);
+  free(buffer->data);
+  free(buffer->mask);
+  buffer->blocks = NULL;
+  buffer->arrival = NULL;
+  buffer->data = NULL;
+  buffer->mask = NULL;
+}
+
+/**
+ * Function used to drop every pending store, e.g. when the caches are
+ * reset with the rest of the hierarchy.
+ */
+void resetWriteBuffer(WriteBuffer *buffer) {
+  buffer->head = 0;
+  buffer->count = 0;
+  buffer->draining = 0;
+  buffer->busy = 0;
+}
+
+/**
+ * Function used to find the entry of a block. With merging set the head
+ * is skipped while it drains, since new stores can no longer join it.
+ * Returns the entry or NO_ENTRY.
+ */
+uint32_t findEntry(WriteBuffer *buffer, uint64_t block, int merging) {
+  for (uint32_t i = merging && buffer->draining; i < buffer->count; i++) {
+    uint32_t entry = bufferEntry(buffer, i);
+    if (buffer->blocks[entry] == block)
+      return entry;
+  }
+  return NO_ENTRY;
+}
+
+/**
+ * Function used to add an empty entry for a block at the tail. The buffer
+ * must not be full.
+ * Returns the new entry.
+ */
+uint32_t pushEntry(WriteBuffer *buffer, uint64_t block, uint64_t time) {
+  uint32_t entry = bufferEntry(buffer, buffer->count++);
+
+  buffer->blocks[entry] = block;
+  buffer->arrival[entry] = time;
+  memset(&buffer->mask[(size_t)entry * buffer->blockSize], 0, buffer->blockSize);
+  return entry;
+}
+
+/**
+ * Function used to merge size bytes stored at offset in the block of an
+ * entry. Tag-only simulators store no data, only which bytes were written.
+ */
+void mergeStore(WriteBuffer *buffer, uint32_t entry, uint32_t offset, const uint8_t *data,
+                uint32_t size) {
+  size_t first = (size_t)entry * buffer->blockSize + offset;
+
+  if (data != NULL)
+    memcpy(&buffer->data[first], data, size);
+  memset(&buffer->mask[first], 1, size);
+}
+
+/**
+ * Function used to remove the head entry once it has drained.
+ */
+void popEntry(WriteBuffer *buffer) {
+  buffer->head = bufferEntry(buffer, 1);
+  buffer->count--;
+  buffer->draining = 0;
+}
+
+/**
+ * Function used to append the pending stores of a write buffer to a
+ * checkpoint.
+ * Returns 0 on success and -1 on a write error.
+ */
+int saveWriteBuffer(const WriteBuffer *buffer, FILE *file) {
+  size_t Bytes = (size_t)buffer->entries * buffer->blockSize;
+
+  if (saveBytes(file, &buffer->head, sizeof(buffer->head)) != 0 ||
+      saveBytes(file, &buffer->count, sizeof(buffer->count)) != 0 ||
+      saveBytes(file, &buffer->draining, sizeof(buffer->draining)) != 0 ||
+      saveBytes(file, &buffer->busy, sizeof(buffer->busy)) != 0 ||
+      saveBytes(file, buffer->blocks, buffer->entries * sizeof(uint64_t)) != 0 ||
+      saveBytes(file, buffer->arrival, buffer->entries * sizeof(uint64_t)) != 0 ||
+      saveBytes(file, buffer->data, Bytes) != 0 || saveBytes(file, buffer->mask, Bytes) != 0)
+    return -1;
+  return 0;
+}
+
+/**
+ * Function used to restore the stores saved by saveWriteBuffer() into a
+ * buffer of the same size.
+ * Returns 0 on success and -1 if the checkpoint is too short.
+ */
+int loadWriteBuffer(WriteBuffer *buffer, Snapshot *snapshot) {
+  size_t Bytes = (size_t)buffer->entries * buffer->blockSize;
+
+  if (loadBytes(snapshot, &buffer->head, sizeof(buffer->head)) != 0 ||
+      loadBytes(snapshot, &buffer->count, sizeof(buffer->count)) != 0 ||
+      loadBytes(snapshot, &buffer->draining, sizeof(buffer->draining)) != 0 ||
+      loadBytes(snapshot, &buffer->busy, sizeof(buffer->busy)) != 0 ||
+      loadBytes(snapshot, buffer->blocks, buffer->entries * sizeof(uint64_t)) != 0 ||
+      loadBytes(snapshot, buffer->arrival, buffer->entries * sizeof(uint64_t)) != 0 ||
+      loadBytes(snapshot, buffer->data, Bytes) != 0 ||
+      loadBytes(snapshot, buffer->mask, Bytes) != 0)
+    return -1;
+  return 0;
+}
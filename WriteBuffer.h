@@ -0,0 +1,51 @@
+#ifndef WRITEBUFFER_H
+#define WRITEBUFFER_H
+
+#include <stdint.h>
+#include "Checkpoint.h"
+
+#define NO_ENTRY UINT32_MAX
+
+/*
+ * Bounded FIFO of pending stores between the L1 and the next level. Each
+ * entry holds the stores to one block, merged: data keeps the bytes and
+ * mask marks the ones written. Entries drain one at a time in the
+ * background, the head being drained while draining is set, until busy.
+ */
+typedef struct WriteBuffer {
+  uint32_t entries;
+  uint32_t blockSize;
+  uint32_t head;
+  uint32_t count;
+  int draining;
+  uint64_t busy;        // time the head finishes draining
+  uint64_t *blocks;     // block address of each entry
+  uint64_t *arrival;    // time of the first store of each entry
+  uint8_t *data;        // entries * blockSize bytes
+  uint8_t *mask;        // entries * blockSize flags
+} WriteBuffer;
+
+/*********************** Write buffer *************************/
+
+int initWriteBuffer(WriteBuffer *buffer, uint32_t entries, uint32_t blockSize);
+void freeWriteBuffer(WriteBuffer *buffer);
+void resetWriteBuffer(WriteBuffer *buffer);
+
+uint32_t findEntry(WriteBuffer *buffer, uint64_t block, int merging);
+uint32_t pushEntry(WriteBuffer *buffer, uint64_t block, uint64_t time);
+void mergeStore(WriteBuffer *buffer, uint32_t entry, uint32_t offset, const uint8_t *data,
+                uint32_t size);
+void popEntry(WriteBuffer *buffer);
+
+int saveWriteBuffer(const WriteBuffer *buffer, FILE *file);
+int loadWriteBuffer(WriteBuffer *buffer, Snapshot *snapshot);
+
+/**
+ * Function used to get the i-th entry from the head, i < count.
+ */
+static inline uint32_t bufferEntry(const WriteBuffer *buffer, uint32_t i) {
+  uint32_t entry = buffer->head + i;
+  return entry < buffer->entries ? entry : entry - buffer->entries;
+}
+
+#endif